@@ -0,0 +1,112 @@
+#ifndef EMG_AMPLITUDE_CALIBRATOR_H_
+#define EMG_AMPLITUDE_CALIBRATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+* Streaming quantile estimate with the P-square algorithm (Jain and Chlamtac, 1985).
+* Five markers, O(1) time and memory per observation.
+*/
+class EMGP2Quantile
+{
+public:
+	EMGP2Quantile();
+
+	void reset(double quantile);
+
+	void add(double x);
+
+	/**
+	* Current estimate, exact for the first five observations.
+	*/
+	double value() const;
+
+	uint64_t count() const
+	{
+		return count_;
+	}
+
+protected:
+	double parabolic(int i, double d) const;
+	double linear(int i, int d) const;
+
+	double p_;
+	uint64_t count_;
+	double q_[5];		//!< Marker heights
+	double n_[5];		//!< Marker positions
+	double np_[5];		//!< Desired marker positions
+	double dn_[5];		//!< Desired position increments
+};
+
+/**
+* Estimation of the maximum voluntary contraction amplitude of every channel.
+*
+* The amplitude of each sample is either |x| or the RMS over a sliding window;
+* the MVC is the given high percentile of that amplitude (P-square sketch) or its
+* maximum when the percentile is 1. Once settled, samples larger than outlierFactor
+* times the current amplitude (window RMS, or the estimate for |x|) are clipped to that
+* bound: a single spike no longer sets the normalization of a channel, while a sustained
+* contraction still raises the estimate within a few windows.
+* Fixed memory, O(1) per sample and channel.
+*/
+class EMGAmplitudeCalibrator
+{
+public:
+	enum Method
+	{
+		ABSOLUTE,	//!< Amplitude is |x|
+		WINDOW_RMS	//!< Amplitude is the RMS over the last window samples
+	};
+
+	EMGAmplitudeCalibrator();
+
+	/**
+	* @param method Amplitude measure
+	* @param window Window length in samples for WINDOW_RMS
+	* @param percentile Quantile of the amplitude used as MVC, in ]0, 1], 1 is the maximum
+	* @param outlierFactor Clip samples above outlierFactor times the current amplitude, 0 disables
+	* @param nbChannel Number of channels
+	*/
+	void setup(Method method, size_t window, double percentile, double outlierFactor, size_t nbChannel);
+
+	/**
+	* Restart the estimation.
+	*/
+	void reset();
+
+	/**
+	* Add one sample of every channel and write the current estimate.
+	* @param maxAmp Updated for every channel with an estimate
+	*/
+	void update(const double* data, double* maxAmp);
+
+	/**
+	* Number of samples clipped as outliers
+	*/
+	uint64_t getRejected() const
+	{
+		return rejected_;
+	}
+
+protected:
+	Method method_;
+	size_t window_;
+	double percentile_;
+	double outlierFactor_;
+	size_t nbChannel_;
+
+	std::vector<double> squares_;		//!< window_ rows of nbChannel_ squared samples
+	std::vector<double> sums_;			//!< Sum of the window per channel
+	std::vector<double> blockSums_;		//!< Sum per channel of the rows written since row 0
+	size_t row_;						//!< Next row written in squares_
+	size_t filled_;						//!< Rows written, up to window_
+	std::vector<double> amplitude_;		//!< Amplitude of the current sample
+	std::vector<EMGP2Quantile> quantiles_;
+	std::vector<double> max_;			//!< Used when percentile_ is 1
+	std::vector<uint64_t> accepted_;
+	uint64_t rejected_;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef EMG_BINARY_PACKET_H_
+#define EMG_BINARY_PACKET_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Fixed-layout binary EMG packet (version 1).
+*
+* All fields are little-endian and packed, the samples directly follow the header:
+*
+*   offset  size  field
+*   0       4     magic         'E' 'M' 'G' 'U' (0x55474D45 read as uint32)
+*   4       1     version       1
+*   5       1     sampleType    1 = float32, 2 = float64
+*   6       2     channelCount  number of samples in the payload
+*   8       4     sequence      incremented by one for every packet sent
+*   12      4     flags         FLAG_FRAGMENT or 0
+*   16      8     senderTime    float64, sender clock in seconds
+*   24      ...   channelCount samples of sampleType, in the subject XML channel order
+*
+* The header is 24 bytes so float64 samples stay 8-byte aligned in the datagram.
+*
+* A frame too large for one datagram is split into fragments sharing its sequence
+* number and sender time. With FLAG_FRAGMENT, an 8-byte fragment header follows the
+* packet header and channelCount is the number of samples of this fragment:
+*
+*   24      2     firstChannel  index of the first sample of the fragment in the frame
+*   26      2     totalChannels channels of the whole frame
+*   28      1     index         fragment index, 0 to count - 1
+*   29      1     count         fragments of the frame, 1 to 64
+*   30      2     reserved      0
+*   32      ...   channelCount samples of sampleType
+*/
+struct EMGPacketHeader
+{
+	uint32_t magic;
+	uint8_t version;
+	uint8_t sampleType;
+	uint16_t channelCount;
+	uint32_t sequence;
+	uint32_t flags;
+	double senderTime;
+};
+
+struct EMGFragmentHeader
+{
+	uint16_t firstChannel;
+	uint16_t totalChannels;
+	uint8_t index;
+	uint8_t count;
+};
+
+class EMGBinaryPacket
+{
+public:
+	static const uint32_t MAGIC = 0x55474D45; //!< "EMGU" in memory order
+	static const uint8_t VERSION = 1;
+	static const size_t HEADER_SIZE = 24;
+	static const uint32_t FLAG_FRAGMENT = 1;
+	static const size_t FRAGMENT_HEADER_SIZE = 8;
+	static const size_t MAX_FRAGMENTS = 64;
+
+	enum SampleType
+	{
+		FLOAT32 = 1,
+		FLOAT64 = 2
+	};
+
+	enum Status
+	{
+		OK,
+		TOO_SHORT,		//!< Datagram smaller than the header
+		BAD_MAGIC,		//!< Not a binary EMG packet
+		BAD_VERSION,	//!< Unsupported version
+		BAD_SAMPLE_TYPE,//!< Unknown sample type
+		BAD_SIZE,		//!< Datagram size differs from the header plus channelCount samples
+		FRAGMENT,		//!< Fragment of a larger frame, decode it with decodeFragmentHeader()
+		BAD_FRAGMENT	//!< Fragment header inconsistent with the payload
+	};
+
+	/**
+	* Check if a datagram starts with the binary packet magic number.
+	*/
+	static bool isBinary(const char* buffer, size_t size);
+
+	/**
+	* Decode a datagram directly from the receive buffer, no allocation.
+	* If the packet carries fewer channels than nbChannel the remaining ones are set to 0,
+	* extra channels are ignored (same behaviour as the text format).
+	* @param buffer Received datagram
+	* @param size Size of the datagram in bytes
+	* @param data Output array of nbChannel values
+	* @param nbChannel Number of channels expected (subject XML)
+	* @param header Decoded header in host byte order
+	*/
+	static Status decode(const char* buffer, size_t size, double* data, size_t nbChannel, EMGPacketHeader& header);
+
+	/**
+	* Decode and check the headers of a fragment, the samples are not read.
+	* @param header Decoded packet header
+	* @param fragment Decoded fragment header
+	*/
+	static Status decodeFragmentHeader(const char* buffer, size_t size, EMGPacketHeader& header, EMGFragmentHeader& fragment);
+
+	/**
+	* Decode the samples of a fragment into its channels of the frame, the other channels
+	* are untouched. Channels beyond nbChannel are ignored.
+	* @param header, fragment Headers returned OK by decodeFragmentHeader() for this buffer
+	* @param frame Output array of nbChannel values, the whole frame
+	*/
+	static void decodeFragmentSamples(const char* buffer, const EMGPacketHeader& header, const EMGFragmentHeader& fragment,
+		double* frame, size_t nbChannel);
+
+	/**
+	* Encode a packet, used by the test senders.
+	* @return Size of the packet in bytes, 0 if the buffer is too small
+	*/
+	static size_t encode(char* buffer, size_t bufferSize, const double* data, size_t nbChannel,
+		uint32_t sequence, double senderTime, SampleType sampleType = FLOAT32);
+
+	/**
+	* Encode one fragment of a frame, used by the test senders.
+	* @param frame The whole frame of totalChannels values
+	* @param firstChannel First channel of the fragment
+	* @param nbChannel Channels in the fragment
+	* @return Size of the datagram in bytes, 0 if the buffer is too small or the fragment invalid
+	*/
+	static size_t encodeFragment(char* buffer, size_t bufferSize, const double* frame, size_t firstChannel, size_t nbChannel,
+		size_t totalChannels, size_t index, size_t count, uint32_t sequence, double senderTime, SampleType sampleType = FLOAT32);
+
+	/**
+	* Channels of a fragment that fit in a datagram of maxSize bytes.
+	*/
+	static size_t fragmentChannels(size_t maxSize, SampleType sampleType);
+
+	/**
+	* Human readable status.
+	*/
+	static const char* statusString(Status status);
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef EMG_CLOCK_SYNC_H_
+#define EMG_CLOCK_SYNC_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Maps the sender time stamps of the samples to the host clock.
+*
+* The receive time is the acquisition time plus a delay that is never negative:
+* transport, kernel and thread wakeup. The sender time window is split into NB_BLOCK
+* blocks and the sample of each block that arrived with the smallest delay is kept;
+* the drift is the least squares slope of these points and the offset puts the line
+* on their lower envelope. Between two fits, a sample received before its mapped time
+* lowers the offset at once. The constant part of the minimum delay cannot be seen
+* from one-way time stamps and stays in the mapped time.
+* A sender time going backwards or a delay above the reset threshold (sender
+* restart) restarts the estimation.
+* Fixed memory, receive thread only except getEstimate().
+*/
+class EMGClockSync
+{
+public:
+	static const size_t NB_BLOCK = 64;
+
+	struct Estimate
+	{
+		double offset;		//!< Host time minus sender time at the last sample, s
+		double drift;		//!< Host clock rate relative to the sender clock minus 1, 1e-6 is 1 ppm
+		double delay;		//!< Receive time minus mapped time of the last sample, s
+		uint64_t samples;	//!< Samples mapped since the last restart
+		uint64_t resets;	//!< Restarts of the estimation
+	};
+
+	EMGClockSync();
+
+	/**
+	* @param window Sender time covered by the fit, s
+	* @param resetThreshold Delay above which the estimation restarts, s
+	*/
+	void setup(double window, double resetThreshold = 1.0);
+
+	bool isEnabled() const
+	{
+		return window_ > 0.0;
+	}
+
+	/**
+	* Add a sample to the estimation and map its sender time.
+	* @param senderTime Time stamp of the sample, sender clock
+	* @param arrivalTime Receive time, host clock
+	* @return Acquisition time on the host clock, never after arrivalTime
+	*/
+	double map(double senderTime, double arrivalTime);
+
+	/**
+	* Last estimate, lock-free, can be called from any thread.
+	*/
+	Estimate getEstimate() const;
+
+protected:
+	void restart(double senderTime, double arrivalTime);
+	void fit();
+	void publish(double senderTime, double hostTime, double arrivalTime);
+
+	double window_;
+	double blockDuration_;
+	double resetThreshold_;
+
+	bool started_;
+	double senderOrigin_;	//!< Times are relative to the first sample, for precision
+	double hostOrigin_;
+	double lastX_;
+	double intercept_;		//!< Mapped host time = hostOrigin_ + intercept_ + slope_ * (senderTime - senderOrigin_)
+	double slope_;
+
+	double blockStart_;		//!< Sender time of the first sample of the current block
+	double blockX_;			//!< Point of the smallest delay in the current block
+	double blockY_;
+	double pointX_[NB_BLOCK];	//!< Smallest delay point of the last blocks
+	double pointY_[NB_BLOCK];
+	size_t pointHead_;
+	size_t pointCount_;
+	uint64_t samples_;
+	uint64_t resets_;
+
+	// Seqlock of the published estimate: odd while being written
+	std::atomic<uint64_t> version_;
+	std::atomic<double> offset_;
+	std::atomic<double> drift_;
+	std::atomic<double> delay_;
+	std::atomic<uint64_t> publishedSamples_;
+	std::atomic<uint64_t> publishedResets_;
+};
+
+#endif
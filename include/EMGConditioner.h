@@ -0,0 +1,99 @@
+#ifndef EMG_CONDITIONER_H_
+#define EMG_CONDITIONER_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+* Second order IIR section applied to all channels at once.
+* Structure of arrays: the state of the channels is stored contiguously per
+* delay element so the per-sample loop over channels vectorizes (one channel per SIMD lane).
+*
+* Difference equation, same convention as the coefficients of executionEMG.xml:
+*   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+* implemented in transposed direct form II. The leading coefficient is implicit
+* when it is 1: two aCoeff are a1 a2, two bCoeff are b1 b2 with b0 = 1, as the
+* dcFilter of executionEMG_ankle_knee.xml ("-1.974 0.9743").
+*/
+class EMGBiquadBank
+{
+public:
+	EMGBiquadBank();
+
+	/**
+	* Set the coefficients and reset the state.
+	* @param aCoeff a1 a2 (a0 = 1 is implicit), fewer values are padded with 0
+	* @param bCoeff b0 b1 b2, or b1 (b2) with b0 = 1 implicit
+	* @param nbChannel Number of channels filtered in parallel
+	* @return false if there are more than 2 a or 3 b coefficients
+	*/
+	bool setup(const std::vector<double>& aCoeff, const std::vector<double>& bCoeff, size_t nbChannel);
+
+	/**
+	* Filter one sample of every channel in place.
+	*/
+	void process(double* data);
+
+	void reset();
+
+	bool isEnabled() const
+	{
+		return enabled_;
+	}
+
+	/**
+	* Gain at 0 Hz, (b0 + b1 + b2) / (1 + a1 + a2), infinite for a pole at DC.
+	*/
+	double getDCGain() const;
+
+protected:
+	bool enabled_;
+	size_t nbChannel_;
+	double b0_, b1_, b2_, a1_, a2_;
+	std::vector<double> s1_; //!< First delay element of every channel
+	std::vector<double> s2_; //!< Second delay element of every channel
+};
+
+/**
+* Real-time EMG conditioning: DC removal, high-pass, full-wave rectification
+* and low-pass envelope, per channel, using the dcFilter, hpFilter and lpFilter
+* coefficients of executionEMG.xml. A filter without coefficients is skipped.
+*/
+class EMGConditioner
+{
+public:
+	EMGConditioner();
+
+	//! Largest DC gain of a dcFilter that still counts as removing DC
+	static const double MAX_DC_GAIN;
+
+	/**
+	* @return false if one of the filters has invalid coefficients
+	*/
+	bool setup(const std::vector<double>& dcA, const std::vector<double>& dcB,
+		const std::vector<double>& hpA, const std::vector<double>& hpB,
+		const std::vector<double>& lpA, const std::vector<double>& lpB, size_t nbChannel);
+
+	/**
+	* Raw EMG in, envelope out, in place.
+	*/
+	void process(double* data);
+
+	void reset();
+
+	/**
+	* DC gain of the dcFilter, 1 without dcFilter. Above MAX_DC_GAIN the coefficients do not remove DC.
+	*/
+	double getDCGain() const
+	{
+		return dcFilter_.isEnabled() ? dcFilter_.getDCGain() : 1.0;
+	}
+
+protected:
+	size_t nbChannel_;
+	EMGBiquadBank dcFilter_;
+	EMGBiquadBank hpFilter_;
+	EMGBiquadBank lpFilter_;
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef EMG_FAN_IN_H_
+#define EMG_FAN_IN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+* Merge of several senders, each one providing a subset of the channels, into full frames.
+*
+* Samples are matched by sequence number (senders numbering their samples from a
+* common start) or by sender time stamp within a tolerance. A frame is published as
+* soon as every source contributed, in key order. A frame still incomplete when a
+* newer one completes, when its oldest contribution is older than the stall timeout,
+* or when the pending window is full, is resolved with the stall policy: the missing
+* channels hold the last value of their source, are set to zero, or the frame is dropped.
+* A source whose key steps back by more than the window (SEQUENCE) or 1 s (SENDER_TIME)
+* restarted: the frames numbered before are published and the alignment starts over.
+* The pending frames are kept in key order: the oldest one is found in constant time
+* and the frame of a sample by binary search. A bound on the first arrivals skips the
+* timeout scan until a frame may have timed out.
+* Fixed memory after setup(), no allocation per sample; receive thread only.
+*/
+class EMGFanIn
+{
+public:
+	enum Alignment
+	{
+		SEQUENCE,		//!< Same sequence number
+		SENDER_TIME		//!< Sender time stamps within the tolerance
+	};
+
+	enum StallPolicy
+	{
+		HOLD,	//!< Missing channels keep the last value of their source
+		ZERO,	//!< Missing channels are set to 0
+		DROP	//!< Incomplete frames are discarded
+	};
+
+	struct Counters
+	{
+		uint64_t frames;		//!< Frames published
+		uint64_t incomplete;	//!< Frames published with missing sources (HOLD, ZERO)
+		uint64_t dropped;		//!< Incomplete frames discarded (DROP)
+		uint64_t late;			//!< Samples older than the last published frame, or duplicates
+		uint64_t restarts;		//!< Senders that started their numbering or clock over
+	};
+
+	EMGFanIn();
+
+	/**
+	* @param channels Index in the frame of every channel of every source
+	* @param nbChannel Size of a frame
+	* @param alignment How the samples of the sources are matched
+	* @param tolerance Maximum sender time difference for SENDER_TIME, in seconds
+	* @param policy What to do with the frames a source did not contribute to
+	* @param timeout Seconds after the first contribution before a frame is resolved with the policy
+	* @param window Maximum number of frames being assembled
+	*/
+	void setup(const std::vector<std::vector<size_t>>& channels, size_t nbChannel, Alignment alignment,
+		double tolerance, StallPolicy policy, double timeout, size_t window = 32);
+
+	/**
+	* Add the sample of one source.
+	* @param values Channels of the source, in the order given to setup()
+	* @param now Receive time, in seconds
+	*/
+	void add(size_t source, const double* values, uint64_t sequence, double senderTime, double now);
+
+	/**
+	* Resolve the frames whose timeout has elapsed.
+	*/
+	void expire(double now);
+
+	/**
+	* Get the next frame ready, oldest first.
+	* @param time Receive time of the last contribution
+	* @param sequence Sequence of the frame (SEQUENCE) or frame counter (SENDER_TIME)
+	* @return false if no frame is ready
+	*/
+	bool pop(double* frame, double& time, uint64_t& sequence);
+
+	/**
+	* Time at which a pending frame times out, never later than the first one, negative if none is pending.
+	*/
+	double nextDeadline() const;
+
+	const Counters& getCounters() const
+	{
+		return counters_;
+	}
+
+	size_t getNbSources() const
+	{
+		return channels_.size();
+	}
+
+protected:
+	struct Slot
+	{
+		bool used;
+		double key;				//!< Sequence or sender time of the frame
+		uint32_t mask;			//!< Sources received
+		double firstArrival;
+		double lastArrival;
+	};
+
+	/**
+	* Slot of the i-th pending frame, in key order.
+	*/
+	size_t pending(size_t i) const
+	{
+		return order_[(orderHead_ + i) % order_.size()];
+	}
+
+	/**
+	* Position in the pending frames of the first key not below key, or above it with after.
+	*/
+	size_t search(double key, bool after) const;
+
+	/**
+	* Move the oldest pending frame to the output, applying the stall policy if it is incomplete.
+	*/
+	void resolveOldest();
+
+	/**
+	* Move a frame to the output, applying the stall policy if it is incomplete. The slot is already free.
+	*/
+	void publish(size_t index);
+
+	/**
+	* A sender started over: publish the pending frames from oldKeys on, numbered before the restart.
+	*/
+	void restart(double oldKeys);
+
+	std::vector<std::vector<size_t>> channels_;
+	size_t nbChannel_;
+	Alignment alignment_;
+	double tolerance_;
+	StallPolicy policy_;
+	double timeout_;
+	uint32_t fullMask_;
+
+	std::vector<Slot> slots_;
+	std::vector<double> values_;		//!< Frame of each slot, slots_.size() rows of nbChannel_
+	std::vector<size_t> order_;			//!< Ring of the used slots in key order, oldest at orderHead_
+	size_t orderHead_;
+	size_t nbPending_;
+	std::vector<size_t> free_;			//!< Unused slots, the first nbFree_
+	size_t nbFree_;
+	size_t nbComplete_;					//!< Pending frames every source contributed to
+	double firstArrivalBound_;			//!< No pending frame arrived first before, refreshed by expire()
+	std::vector<double> lastValues_;	//!< Last published value of every channel, for HOLD
+	std::vector<double> sourceKey_;		//!< Highest key of each source since its last restart
+	bool hasPublished_;
+	double lastKey_;					//!< Key of the last frame published or dropped
+
+	// Output queue, frames in publish order
+	std::vector<double> ready_;			//!< slots_.size() rows of nbChannel_
+	std::vector<double> readyTime_;
+	std::vector<uint64_t> readySequence_;
+	size_t readyHead_;
+	size_t readyCount_;
+	uint64_t frameCounter_;
+
+	Counters counters_;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef EMG_FRAME_ASSEMBLER_H_
+#define EMG_FRAME_ASSEMBLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EMGBinaryPacket.h"
+
+/**
+* Reassembles the frames a sender split into several binary packets (FLAG_FRAGMENT).
+*
+* Each fragment is decoded straight into the slot of its frame, selected by the
+* sequence number among a fixed number of frames in progress, once its headers are
+* valid and it is neither late nor a duplicate. A frame is complete
+* once each of its fragments arrived once. A frame that does not complete within the
+* timeout, or whose slot is needed by a newer frame, is dropped and counted; the
+* channels no fragment covers are 0.
+* A fragment more than 64 maxPending frames behind the newest one is taken as a sender
+* restart: the frames in progress are dropped and the numbering starts over.
+* Fixed memory after setup(), no allocation per fragment; receive thread only.
+*/
+class EMGFrameAssembler
+{
+public:
+	struct Counters
+	{
+		uint64_t fragments;		//!< Fragments decoded
+		uint64_t frames;		//!< Frames completed
+		uint64_t incomplete;	//!< Frames dropped on timeout or for a newer frame
+		uint64_t late;			//!< Fragments of a frame already completed or dropped, or duplicates
+		uint64_t invalid;		//!< Fragments with an inconsistent header
+		uint64_t restarts;		//!< Sequence jumps back far beyond maxPending, the sender restarted
+	};
+
+	EMGFrameAssembler();
+
+	/**
+	* @param nbChannel Channels of a frame (subject XML)
+	* @param maxPending Frames in progress at the same time
+	* @param timeout Seconds a frame waits for its missing fragments
+	*/
+	void setup(size_t nbChannel, size_t maxPending, double timeout);
+
+	/**
+	* Add a fragment.
+	* @param header Header of the packet, decoded by EMGBinaryPacket::decode()
+	* @param now Receive time of the fragment
+	* @param frame Output array of nbChannel values, written when the frame completes
+	* @return true if this fragment completed its frame
+	*/
+	bool add(const EMGPacketHeader& header, const char* buffer, size_t size, double now, double* frame);
+
+	/**
+	* Drop the frames that have waited more than the timeout.
+	*/
+	void expire(double now);
+
+	/**
+	* Time at which the oldest frame in progress times out, -1 if none.
+	*/
+	double nextDeadline() const;
+
+	const Counters& getCounters() const
+	{
+		return counters_;
+	}
+
+	size_t getNbChannel() const
+	{
+		return nbChannel_;
+	}
+
+protected:
+	struct Slot
+	{
+		bool active;		//!< Frame in progress
+		uint32_t sequence;	//!< Sequence of the frame in progress or of the last one in this slot
+		uint64_t received;	//!< Bit per fragment index
+		uint64_t expected;	//!< Bits of all the fragments
+		double start;		//!< Receive time of the first fragment
+	};
+
+	/**
+	* Drop the frames in progress, the next fragment starts a new numbering.
+	*/
+	void restart();
+
+	size_t nbChannel_;
+	double timeout_;
+	std::vector<Slot> slots_;
+	std::vector<double> frames_;	//!< nbChannel_ values per slot
+	bool started_;
+	uint32_t lastSequence_;			//!< Newest frame started
+	Counters counters_;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef EMG_KERNELS_H_
+#define EMG_KERNELS_H_
+
+#include <cstddef>
+
+/**
+* Per-sample kernels of the receive path, specialized on the channel count.
+*
+* The loops are branch-free (select instead of if) and, for the common channel
+* counts, instantiated with a compile-time trip count so the compiler unrolls and
+* vectorizes them completely. select() picks the implementation once, at init().
+*/
+namespace EMGKernels
+{
+	/**
+	* maxAmp[i] = max(maxAmp[i], data[i]); a NaN sample leaves maxAmp unchanged.
+	*/
+	typedef void (*UpdateMax)(const double* data, double* maxAmp, size_t nbChannel);
+
+	/**
+	* data[i] = min(data[i] / maxAmp[i], 1), or 0 when maxAmp[i] <= 1e-6.
+	*/
+	typedef void (*Normalize)(double* data, const double* maxAmp, size_t nbChannel);
+
+	struct Functions
+	{
+		UpdateMax updateMax;
+		Normalize normalize;
+		size_t specialization; //!< Channel count of the kernels, 0 for the generic loops
+	};
+
+	/**
+	* Kernels for 8, 16, 32 or 64 channels, generic loops otherwise.
+	*/
+	Functions select(size_t nbChannel);
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef EMG_METRICS_H_
+#define EMG_METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "EMGSampleRing.h"
+
+/**
+* Log-linear histogram (HDR style) of positive integer values, typically nanoseconds.
+* 16 sub-buckets per power of two: about 6% relative precision over the full 64-bit range,
+* fixed memory, O(1) record. One writer thread, any number of reader threads, no lock.
+*/
+class EMGHistogram
+{
+public:
+	static const int SUB_BITS = 4;
+	static const size_t SUB_COUNT = size_t(1) << SUB_BITS;
+	static const size_t NB_BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+	struct Summary
+	{
+		uint64_t count;
+		double mean;
+		uint64_t p50;
+		uint64_t p90;
+		uint64_t p99;
+		uint64_t p999;
+		uint64_t max;
+	};
+
+	EMGHistogram();
+
+	/**
+	* Writer thread only.
+	*/
+	void record(uint64_t value);
+
+	/**
+	* Value below which the given fraction of the recorded values are, upper bound of its bucket.
+	*/
+	uint64_t percentile(double fraction) const;
+
+	Summary summarize() const;
+
+	uint64_t getCount() const
+	{
+		return count_.load(std::memory_order_relaxed);
+	}
+
+protected:
+	static size_t bucketIndex(uint64_t value);
+	static uint64_t bucketUpperBound(size_t index);
+
+	std::atomic<uint64_t> buckets_[NB_BUCKETS];
+	std::atomic<uint64_t> count_;
+	std::atomic<uint64_t> sum_;
+	std::atomic<uint64_t> max_;
+};
+
+/**
+* Always-on metrics of the receive path.
+*
+* Each group of counters has a single writer: the receive thread (packets, parse
+* time, sequence, latency, jitter) or the GetDataMap() caller (sample age). Writers
+* use plain relaxed loads and stores, without read-modify-write or lock, and the
+* two groups live on separate cache lines. snapshot() can be called from any thread.
+*/
+class EMGMetrics
+{
+public:
+	static const uint32_t RESTART_WINDOW = 1024; //!< Larger backward steps of the sequence numbers are sender restarts
+
+	struct Snapshot
+	{
+		uint64_t received;				//!< Datagrams given to the decoder
+		uint64_t parsed;				//!< Datagrams decoded
+		uint64_t malformed;				//!< Datagrams skipped by the decoder
+		uint64_t overruns;				//!< Samples lost because the ring was full
+		uint64_t dropped;				//!< Samples skipped by the latest-only read policy
+		uint64_t sequenceGaps;			//!< Packets missing according to the sequence numbers
+		uint64_t reordered;				//!< Packets older than the last sequence number
+		uint64_t sequenceRestarts;		//!< Sequence numbers going back more than RESTART_WINDOW, sender restarts
+		uint64_t lost;					//!< Samples the reorder buffer gave up on
+		uint64_t filled;				//!< Lost samples replaced by the reorder buffer
+		uint64_t late;					//!< Samples the reorder buffer discarded, too late or duplicated
+		double jitter;					//!< Inter-arrival jitter in seconds (RFC 3550 estimator)
+		EMGHistogram::Summary parseTime;		//!< Decode time, ns
+		EMGHistogram::Summary receiveLatency;	//!< Receive to publish in the ring, ns
+		EMGHistogram::Summary sampleAge;		//!< Publish to GetDataMap(), ns
+		EMGHistogram::Summary interArrival;		//!< Time between two datagrams, ns
+		uint64_t pullReady;				//!< Pull mode reads that found a sample without waiting
+		uint64_t pullWoken;				//!< Pull mode reads woken by a sample before the deadline
+		uint64_t deadlineMisses;		//!< Pull mode reads that reached the deadline without a sample
+		EMGHistogram::Summary pullWait;	//!< Wait of the pull mode reads that waited, ns
+	};
+
+	EMGMetrics();
+
+	/**
+	* Receive thread: a datagram arrived.
+	* @param arrivalTime Receive time in seconds (rtb::getTime() base)
+	* @param senderTime Sender time stamp in seconds, negative if the packet has none
+	*/
+	void packetReceived(double arrivalTime, double senderTime);
+
+	/**
+	* Receive thread: decode result and duration.
+	*/
+	void packetDecoded(bool ok, uint64_t parseTimeNs);
+
+	/**
+	* Receive thread: sequence number of a decoded packet, for the gap count. A step back of
+	* more than RESTART_WINDOW is a sender restart, the count starts over from that number.
+	*/
+	void sequence(uint32_t sequence);
+
+	/**
+	* Receive thread: totals of the reorder buffer.
+	*/
+	void reorderCounters(uint64_t lost, uint64_t filled, uint64_t late);
+
+	/**
+	* Receive thread: sample written in the ring.
+	* @param latency Publish time minus arrival time, in seconds
+	*/
+	void published(double latency);
+
+	/**
+	* GetDataMap() thread: sample read from the ring.
+	* @param age Read time minus publish time, in seconds
+	*/
+	void consumed(double age);
+
+	/**
+	* GetDataMap() thread: outcome of a pull mode wait.
+	* @param waitNs Time spent waiting
+	*/
+	void pulled(EMGSampleRing::WaitResult result, uint64_t waitNs);
+
+	/**
+	* @param ring Counters of the sample ring, for the overruns and drops
+	*/
+	Snapshot snapshot(const EMGSampleRing::Counters& ring) const;
+
+	/**
+	* Counters of snapshot() without the histogram summaries, cheap enough for the receive thread.
+	*/
+	void readCounters(Snapshot& snapshot, const EMGSampleRing::Counters& ring) const;
+
+	/**
+	* Column names of writeRow(), tab separated.
+	*/
+	static void writeHeader(std::ostream& out);
+
+	/**
+	* One tab separated row, times in microseconds.
+	*/
+	static void writeRow(std::ostream& out, double time, const Snapshot& snapshot);
+
+	/**
+	* Monotonic clock for the short durations, in ns.
+	*/
+	static uint64_t now();
+
+protected:
+	static void increment(std::atomic<uint64_t>& counter)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	// Receive thread
+	alignas(EMGSampleRing::CACHE_LINE) std::atomic<uint64_t> received_;
+	std::atomic<uint64_t> parsed_;
+	std::atomic<uint64_t> malformed_;
+	std::atomic<uint64_t> sequenceGaps_;
+	std::atomic<uint64_t> reordered_;
+	std::atomic<uint64_t> sequenceRestarts_;
+	std::atomic<uint64_t> lost_;
+	std::atomic<uint64_t> filled_;
+	std::atomic<uint64_t> late_;
+	std::atomic<double> jitter_;
+	bool hasSequence_;
+	uint32_t lastSequence_;
+	bool hasArrival_;
+	double lastArrival_;
+	double lastSenderTime_;
+	double meanInterval_;			//!< Expected interval when the packets have no sender time
+	EMGHistogram parseTime_;
+	EMGHistogram receiveLatency_;
+	EMGHistogram interArrival_;
+
+	// GetDataMap() thread
+	alignas(EMGSampleRing::CACHE_LINE) EMGHistogram sampleAge_;
+	std::atomic<uint64_t> pullReady_;
+	std::atomic<uint64_t> pullWoken_;
+	std::atomic<uint64_t> deadlineMisses_;
+	EMGHistogram pullWait_;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef EMG_MIXER_H_
+#define EMG_MIXER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+* Linear mixing of the received channels into the channels of the subject XML:
+* out = W in, W of nbOutput rows and nbInput columns (montage, re-referencing,
+* spatial filter).
+*
+* Dense matrices are stored in blocks of BLOCK rows, column by column, so the
+* per-sample product is BLOCK partial sums held in registers, updated with one
+* vectorized multiply-add per input channel; every weight is read once, in order.
+* Matrices with few non-zero weights are stored as compressed sparse rows.
+* Fixed memory after prepare(), no allocation per sample.
+*/
+class EMGMixer
+{
+public:
+	static const size_t BLOCK = 8;
+
+	EMGMixer();
+
+	/**
+	* Zero matrix, disables the mixer until prepare().
+	*/
+	void setup(size_t nbInput, size_t nbOutput);
+
+	/**
+	* Set the weights of an output channel.
+	* @param weights nbInput weights ("0 0.5 -0.5 ..."), or input:weight pairs
+	* with 0-based input indices for sparse rows ("12:1 13:-1")
+	* @return false with a message in error if the text is invalid
+	*/
+	bool setRow(size_t output, const std::string& weights, std::string& error);
+
+	/**
+	* Read a matrix file: one "<channel> <weights>" line per output channel, weights as in
+	* setRow(), lines starting with # are comments.
+	* @param outputs Channel names of the subject XML, in output order
+	* @return false with a message in error if the file is unreadable or a line invalid
+	*/
+	bool load(const std::string& fileName, const std::vector<std::string>& outputs, std::string& error);
+
+	/**
+	* Choose the dense or sparse product and pack the matrix, enables the mixer.
+	*/
+	void prepare();
+
+	/**
+	* out = W in. Zero weights are skipped in both products: a NaN or infinite
+	* input only reaches the outputs that have a non-zero weight for it.
+	* @param in nbInput values
+	* @param out nbOutput values
+	*/
+	void process(const double* in, double* out) const;
+
+	bool isEnabled() const
+	{
+		return enabled_;
+	}
+
+	bool isSparse() const
+	{
+		return sparse_;
+	}
+
+	size_t getNbInput() const
+	{
+		return nbInput_;
+	}
+
+	size_t getNbOutput() const
+	{
+		return nbOutput_;
+	}
+
+	/**
+	* Non-zero weights of the matrix.
+	*/
+	size_t getNonZeros() const;
+
+	/**
+	* Non-zero weights of an output channel.
+	*/
+	size_t getRowNonZeros(size_t output) const;
+
+protected:
+	void processDense(const double* in, double* out) const;
+	void processSparse(const double* in, double* out) const;
+	void processRows(const double* in, double* out) const;	//!< Row by row, skipping zero weights, for non-finite inputs
+	bool isFinite(const double* in) const;
+
+	bool enabled_;
+	bool sparse_;
+	size_t nbInput_;
+	size_t nbOutput_;
+	std::vector<double> weights_;		//!< Row-major, as configured
+
+	std::vector<double> blocked_;		//!< Dense: per block of BLOCK rows, BLOCK weights per input
+	std::vector<size_t> rowStart_;		//!< Sparse: first non-zero of each row, nbOutput_ + 1 entries
+	std::vector<size_t> columns_;		//!< Sparse: input of each non-zero
+	std::vector<double> values_;		//!< Sparse: weight of each non-zero
+};
+
+#endif
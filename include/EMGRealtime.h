@@ -0,0 +1,81 @@
+#ifndef EMG_REALTIME_H_
+#define EMG_REALTIME_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+* Real-time setup of the calling thread and of the process memory.
+* Every function prints a warning and returns false when the system refuses the
+* setting (missing CAP_SYS_NICE / RLIMIT_RTPRIO / RLIMIT_MEMLOCK), the thread then
+* keeps running with its previous settings.
+*/
+namespace EMGRealtime
+{
+	/**
+	* Pin the calling thread to the given CPUs.
+	*/
+	bool setAffinity(const std::vector<int>& cpus);
+
+	/**
+	* SCHED_FIFO at the given priority for the calling thread.
+	* @param priority 1 (lowest) to 99
+	*/
+	bool setFifoPriority(int priority);
+
+	/**
+	* Lock the current and future pages of the process in memory (mlockall) and
+	* touch stackSize bytes of the calling thread stack so no page fault is left
+	* on the receive path.
+	*/
+	bool lockMemory(size_t stackSize);
+}
+
+/**
+* Wait for sockets to be readable or for a stop request.
+* epoll on the socket and on an eventfd written by requestStop(): stopping the
+* receive thread no longer depends on a periodic wakeup.
+*/
+class EMGSocketWaiter
+{
+public:
+	enum Event
+	{
+		READABLE,	//!< Data on a socket
+		STOP,		//!< requestStop() was called
+		TIMEOUT,	//!< Nothing before the timeout
+		ERROR		//!< epoll failure, errno is set
+	};
+
+	EMGSocketWaiter();
+	~EMGSocketWaiter();
+
+	/**
+	* @return false if epoll or eventfd cannot be created
+	*/
+	bool open(int sockFd);
+
+	/**
+	* Also wait on another socket.
+	*/
+	bool add(int sockFd);
+
+	void close();
+
+	/**
+	* Block until a socket is readable or a stop is requested.
+	* @param timeoutMs Maximum wait in milliseconds, -1 for no timeout
+	*/
+	Event wait(int timeoutMs = -1);
+
+	/**
+	* Wake up wait(), can be called from any thread.
+	*/
+	void requestStop();
+
+protected:
+	int epollFd_;
+	int stopFd_;	//!< eventfd
+};
+
+#endif
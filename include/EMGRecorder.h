@@ -0,0 +1,77 @@
+#ifndef EMG_RECORDER_H_
+#define EMG_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EMGSampleRing.h"
+#include "EMGRecordingFile.h"
+
+/**
+* Binary recording sink decoupled from the receive thread.
+* push() copies the sample into a lock-free ring and returns, a writer thread
+* drains the ring into an .emgrec file (see EMGRecordingFile.h) in chunks.
+* Disk speed never reaches the receive thread: when the writer falls behind the
+* ring fills up and the extra samples are counted as overruns.
+*/
+class EMGRecorder
+{
+public:
+	/**
+	* @param capacity Samples buffered between the receive thread and the writer
+	* @param chunkRecords Maximum records per chunk written to the file
+	*/
+	EMGRecorder(size_t capacity = 8192, size_t chunkRecords = 256);
+	~EMGRecorder();
+
+	/**
+	* Create the file and start the writer thread.
+	*/
+	bool start(const std::string& fileName, const std::vector<std::string>& channelNames);
+
+	/**
+	* Receive thread: queue one sample, never blocks.
+	* @param data nbChannel raw values followed by nbChannel normalized values
+	* @return false if the sample was dropped (writer too slow)
+	*/
+	bool push(const double* data, double time, uint64_t sequence)
+	{
+		return ring_ ? ring_->push(data, time, sequence) : false;
+	}
+
+	/**
+	* Write the queued samples, stop the writer thread and close the file.
+	*/
+	void stop();
+
+	uint64_t getWritten() const
+	{
+		return written_.load(std::memory_order_relaxed);
+	}
+
+	uint64_t getDropped() const
+	{
+		return ring_ ? ring_->getCounters().overruns : 0;
+	}
+
+protected:
+	void writerLoop();
+	size_t drain();
+
+	size_t capacity_;
+	size_t chunkRecords_;
+	size_t nbChannel_;
+	std::unique_ptr<EMGSampleRing> ring_;
+	EMGRecordingWriter writer_;
+	std::vector<char> chunk_;
+	std::vector<double> sample_;
+	std::atomic<bool> running_;
+	std::atomic<uint64_t> written_;
+	std::thread writerThread_;
+};
+
+#endif
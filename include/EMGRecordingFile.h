@@ -0,0 +1,112 @@
+#ifndef EMG_RECORDING_FILE_H_
+#define EMG_RECORDING_FILE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+* Binary EMG recording (.emgrec), host byte order (little-endian on the supported platforms).
+*
+*   File header
+*     char[8]   magic "EMGREC1" with terminating '\0'
+*     uint32    nbChannel
+*     uint32    flags, 0
+*     nbChannel times: uint16 length, followed by the channel name (no '\0')
+*   Chunks, until the end of the file
+*     uint32    magic 'CHNK' (0x4B4E4843)
+*     uint32    nbRecords
+*     nbRecords times:
+*       float64   time (receive time, kernel time stamp in batch receive mode)
+*       uint64    sequence
+*       float64   raw[nbChannel] (decoded values, before conditioning)
+*       float64   normalized[nbChannel] (values published to CEINMS-RT)
+*
+* Each chunk is flushed to the OS once written and a truncated last chunk is ignored by the
+* reader, so a crash of the process loses at most one chunk (a power loss, what the OS had not
+* written to disk yet).
+*/
+struct EMGRecord
+{
+	double time;
+	uint64_t sequence;
+	std::vector<double> raw;
+	std::vector<double> normalized;
+};
+
+class EMGRecordingWriter
+{
+public:
+	static const uint32_t CHUNK_MAGIC = 0x4B4E4843;
+
+	EMGRecordingWriter();
+	~EMGRecordingWriter();
+
+	/**
+	* Create the file and write the header.
+	* @return false if the file cannot be created
+	*/
+	bool open(const std::string& fileName, const std::vector<std::string>& channelNames);
+
+	/**
+	* Write one chunk and flush it.
+	* @param records nbRecords records of (2 + 2 * nbChannel) 8-byte words: time, sequence, raw, normalized
+	*/
+	bool writeChunk(const char* records, uint32_t nbRecords);
+
+	void close();
+
+	size_t getRecordSize() const
+	{
+		return recordSize_;
+	}
+
+protected:
+	FILE* file_;
+	size_t recordSize_;
+};
+
+class EMGRecordingReader
+{
+public:
+	EMGRecordingReader();
+	~EMGRecordingReader();
+
+	/**
+	* Open a recording and read its header.
+	* @return false if the file cannot be opened or is not a recording
+	*/
+	bool open(const std::string& fileName);
+
+	/**
+	* Read the next record.
+	* @return false at the end of the file
+	*/
+	bool next(EMGRecord& record);
+
+	/**
+	* Go back to the first record.
+	*/
+	void rewind();
+
+	const std::vector<std::string>& getChannelNames() const
+	{
+		return channelNames_;
+	}
+
+	void close();
+
+protected:
+	bool readChunk();
+
+	FILE* file_;
+	long dataOffset_;					//!< Offset of the first chunk
+	std::vector<std::string> channelNames_;
+	size_t recordSize_;
+	std::vector<char> chunk_;			//!< Current chunk
+	uint32_t chunkRecords_;
+	uint32_t chunkIndex_;				//!< Next record of the chunk
+};
+
+#endif
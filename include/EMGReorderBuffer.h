@@ -0,0 +1,148 @@
+#ifndef EMG_REORDER_BUFFER_H_
+#define EMG_REORDER_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+* Restores the sender order of the samples from their sequence numbers.
+*
+* Samples are released in sequence order. A missing sample is waited for until a
+* later one has been buffered for maxDelay, or until a sample beyond the window
+* arrives; it is then counted as lost and replaced according to the gap fill policy.
+* Samples whose turn has passed are discarded, so a late packet never overwrites a
+* newer sample. A forward jump larger than the window (long outage) is counted as
+* lost without filling it. A backward jump larger than the window is a sender
+* restart: the buffered samples are released and the numbering starts over.
+* Fixed memory after setup(), no allocation per sample; receive thread only.
+*/
+class EMGReorderBuffer
+{
+public:
+	enum GapFill
+	{
+		HOLD,			//!< Last released values
+		INTERPOLATE,	//!< Linear interpolation between the samples around the gap
+		NAN_MARK		//!< Quiet NaN, the gap stays visible downstream
+	};
+
+	struct Counters
+	{
+		uint64_t received;		//!< Samples given to push()
+		uint64_t reordered;		//!< Samples that arrived after a newer one, in time to be put back in order
+		uint64_t lost;			//!< Sequence numbers never received
+		uint64_t filled;		//!< Lost samples replaced with the gap fill policy
+		uint64_t late;			//!< Samples discarded because their turn had passed
+		uint64_t duplicates;	//!< Sequence numbers received twice
+		uint64_t restarts;		//!< Backward jumps larger than the window, the numbering started over
+	};
+
+	EMGReorderBuffer();
+
+	/**
+	* @param nbChannel Values per sample
+	* @param window Samples buffered at most, the largest gap that is filled
+	* @param maxDelay Seconds a sample waits for the missing ones before it
+	* @param gapFill How the lost samples are replaced
+	*/
+	void setup(size_t nbChannel, size_t window, double maxDelay, GapFill gapFill);
+
+	/**
+	* Add a received sample. pop() returns the samples it made ready.
+	* @param sequence 32-bit wire sequence number, wrap-around is handled
+	* @param time Time stamp of the sample
+	* @param now Receive time, in seconds
+	*/
+	void push(uint32_t sequence, const double* data, double time, double now);
+
+	/**
+	* Give up on the missing samples the buffered ones have waited maxDelay for.
+	*/
+	void expire(double now);
+
+	/**
+	* Get the next sample ready, in sequence order.
+	* @param filled Set if the sample replaces a lost one
+	* @return false if no sample is ready
+	*/
+	bool pop(double* data, double& time, uint64_t& sequence, bool& filled);
+
+	/**
+	* Time at which the oldest buffered sample stops waiting, negative if none.
+	*/
+	double nextDeadline() const;
+
+	const Counters& getCounters() const
+	{
+		return counters_;
+	}
+
+	GapFill getGapFill() const
+	{
+		return gapFill_;
+	}
+
+protected:
+	struct Slot
+	{
+		bool present;
+		uint64_t sequence;
+		double time;
+		double arrival;
+	};
+
+	bool isPresent(uint64_t sequence) const
+	{
+		const Slot& slot = slots_[sequence % slots_.size()];
+		return slot.present && slot.sequence == sequence;
+	}
+
+	/**
+	* Release everything buffered before the sequence numbers start over.
+	*/
+	void restart();
+
+	/**
+	* Release the samples present from nextSequence_ on.
+	*/
+	void releaseInOrder();
+
+	/**
+	* Release nextSequence_, filled if it is missing. There is a buffered sample after it.
+	*/
+	void releaseNext();
+
+	/**
+	* Move a sample to the output queue.
+	*/
+	void release(const double* data, double time, bool filled);
+
+	size_t nbChannel_;
+	double maxDelay_;
+	GapFill gapFill_;
+	std::vector<Slot> slots_;
+	std::vector<double> values_;		//!< Sample of each slot, slots_.size() rows of nbChannel_
+
+	bool started_;
+	uint64_t nextSequence_;				//!< Next sequence number to release
+	uint64_t highestSequence_;			//!< Highest sequence number received
+	uint32_t lastWire_;					//!< Last wire sequence, for the 32-bit unwrap
+	bool hasReleased_;
+	std::vector<double> lastValues_;	//!< Last sample released with values, for HOLD and INTERPOLATE
+	std::vector<double> fill_;
+	double lastTime_;
+	uint64_t lastSequence_;
+
+	// Output queue, samples in sequence order
+	std::vector<double> ready_;			//!< 2 * slots_.size() rows of nbChannel_
+	std::vector<double> readyTime_;
+	std::vector<uint64_t> readySequence_;
+	std::vector<char> readyFilled_;
+	size_t readyHead_;
+	size_t readyCount_;
+
+	Counters counters_;
+};
+
+#endif
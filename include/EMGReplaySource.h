@@ -0,0 +1,99 @@
+#ifndef EMG_REPLAY_SOURCE_H_
+#define EMG_REPLAY_SOURCE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "EMGRecordingFile.h"
+
+/**
+* Recorded EMG session read back sample by sample, paced on the recorded time stamps.
+*
+* Reads the .sto files written by OpenSimFileLogger (time column followed by one
+* column per channel) and the binary .emgrec recordings (raw values, see
+* EMGRecordingFile.h). The file is streamed, long sessions are not loaded in memory.
+* Used by the plugin replay mode and by the EMGReplaySender tool.
+*/
+class EMGReplaySource
+{
+public:
+	EMGReplaySource();
+
+	/**
+	* Open a recording, the format is chosen from the extension (.emgrec, anything else is .sto).
+	* @param channelNames Channels to return, in this order, looked up by name in the file.
+	*        Empty to return all the channels of the file in their order.
+	* @return false if the file cannot be read or a channel is missing
+	*/
+	bool open(const std::string& fileName, const std::vector<std::string>& channelNames = std::vector<std::string>());
+
+	/**
+	* @param speed 1 for real time, N for N times faster, 0 for as fast as possible
+	* @param loop Restart from the beginning at the end of the file
+	*/
+	void setPacing(double speed, bool loop);
+
+	/**
+	* Wait until the next sample is due and read it.
+	* @param data Output array of getChannelNames().size() values
+	* @param time Recorded time stamp of the sample
+	* @return false at the end of the file (never when looping)
+	*/
+	bool next(double* data, double& time);
+
+	/**
+	* Read the next sample without waiting.
+	*/
+	bool read(double* data, double& time);
+
+	/**
+	* Go back to the first sample and restart the pacing.
+	*/
+	void rewind();
+
+	const std::vector<std::string>& getChannelNames() const
+	{
+		return channelNames_;
+	}
+
+	/**
+	* @return true for a .sto, which holds the normalized values published by the plugin,
+	*         false for an .emgrec, whose raw values are returned
+	*/
+	bool isNormalized() const
+	{
+		return !binary_;
+	}
+
+	void close();
+
+protected:
+	bool openSto(const std::string& fileName);
+	bool openRecording(const std::string& fileName);
+	bool mapChannels(const std::vector<std::string>& fileNames, const std::vector<std::string>& channelNames);
+	bool readRow(double& time);
+
+	bool binary_;
+	std::ifstream sto_;
+	std::streampos stoDataOffset_;		//!< First data row of the .sto file
+	std::string line_;					//!< Current .sto row
+	std::vector<double> row_;			//!< Values of the current row, file order
+	EMGRecordingReader recording_;
+	EMGRecord record_;
+	std::vector<std::string> channelNames_;
+	std::vector<size_t> columns_;		//!< File column of each returned channel
+
+	double speed_;
+	bool loop_;
+	bool started_;							//!< Pacing origin set
+	double firstTime_;						//!< Recorded time of the pacing origin
+	double timeOffset_;						//!< Added to the recorded time after a loop
+	double lastTime_;						//!< Last time returned
+	double period_;							//!< Last interval between two samples, spacing of the loops
+	std::chrono::steady_clock::time_point origin_;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef EMG_RESAMPLER_H_
+#define EMG_RESAMPLER_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+* Anti-aliased decimation by an integer factor, run in the receive thread.
+* Windowed-sinc low-pass FIR evaluated only once every factor inputs (the
+* polyphase decimator cost), all channels at once. The output is time stamped
+* with the time of the input sample at the filter group delay, so it stays
+* aligned with the other signals of CEINMS-RT.
+*/
+class EMGDecimator
+{
+public:
+	EMGDecimator();
+
+	/**
+	* @param factor Decimation factor, sender rate / model rate
+	* @param nbTaps FIR length, 0 selects 8 * factor + 1
+	* @param nbChannel Number of channels
+	*/
+	void setup(size_t factor, size_t nbTaps, size_t nbChannel);
+
+	/**
+	* Push one input sample.
+	* @param out Output sample, written when the function returns true
+	* @param outTime Time of the output sample
+	* @return true once every factor inputs
+	*/
+	bool process(const double* in, double time, double* out, double& outTime);
+
+	void reset();
+
+	size_t getFactor() const
+	{
+		return factor_;
+	}
+
+protected:
+	size_t factor_;
+	size_t nbTaps_;
+	size_t nbChannel_;
+	size_t phase_;					//!< Inputs since the last output
+	size_t head_;					//!< Slot of the newest input in the history
+	size_t count_;					//!< Inputs in the history, up to nbTaps_
+	std::vector<double> coeffs_;	//!< FIR coefficients, unity DC gain
+	std::vector<double> history_;	//!< nbTaps_ rows of nbChannel_ values
+	std::vector<double> times_;		//!< Time of each history row
+};
+
+/**
+* Mean or max of all the samples received since the last read, run in GetDataMap().
+*/
+class EMGWindowReducer
+{
+public:
+	enum Mode
+	{
+		MEAN,	//!< Average, time stamped at the mean time of the window
+		MAX		//!< Per channel maximum, NaN if a sample of the window is NaN, time stamped with the newest sample
+	};
+
+	EMGWindowReducer();
+
+	void setup(Mode mode, size_t nbChannel);
+
+	/**
+	* Start a new window.
+	*/
+	void begin();
+
+	void add(const double* data, double time);
+
+	/**
+	* @return false if the window is empty, the outputs are untouched
+	*/
+	bool finish(double* out, double& time);
+
+protected:
+	Mode mode_;
+	size_t nbChannel_;
+	size_t count_;
+	double timeSum_;
+	double lastTime_;
+	std::vector<double> accumulator_;
+};
+
+#endif
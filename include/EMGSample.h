@@ -0,0 +1,21 @@
+#ifndef EMG_SAMPLE_H_
+#define EMG_SAMPLE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Contiguous view of one EMG sample, values in the subject XML channel order (nameVect_).
+* The data pointer stays valid for the lifetime of the plugin, the values are
+* updated by the next read.
+*/
+struct EMGSampleView
+{
+	const double* data;	//!< One value per channel, index-ordered
+	size_t size;		//!< Number of channels
+	double time;		//!< Time stamp of the sample
+	uint64_t sequence;	//!< Sequence number of the sample
+	bool fresh;			//!< false if no new sample arrived since the previous read
+};
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef EMG_SAMPLE_RING_H_
+#define EMG_SAMPLE_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+* Bounded single-producer/single-consumer ring of time stamped EMG samples.
+*
+* The feeder thread is the only producer and GetDataMap() the only consumer,
+* both sides are wait-free. Head and tail live on their own cache line and
+* every slot is padded to a multiple of the cache line size, so producer and
+* consumer never share a line unless they touch the same sample.
+*
+* When the ring is full the new sample is not written and counted as an overrun,
+* samples skipped by readLatest() are counted as dropped. With enableOverwrite(), for the
+* latest-only read policies, a full ring drops its oldest sample instead, so that the newest
+* one is always the one read; the overwritten samples are counted as dropped too.
+*
+* With enableWakeup(), the consumer can block in waitForData() on a futex word
+* the producer bumps after a push, only when the consumer announced that it sleeps.
+*/
+class EMGSampleRing
+{
+public:
+	static const size_t CACHE_LINE = 64;
+
+	/**
+	* What the consumer gets on each read.
+	*/
+	enum ReadPolicy
+	{
+		LATEST,			//!< Newest sample, older ones are dropped, zeros when nothing new
+		OLDEST_FIRST,	//!< One sample per read in arrival order, zeros when nothing new
+		HOLD_LAST		//!< Newest sample, the last one is repeated when nothing new
+	};
+
+	/**
+	* Result of waitForData().
+	*/
+	enum WaitResult
+	{
+		READY,		//!< A sample was already waiting, no wait
+		WOKEN,		//!< A sample was pushed during the wait
+		TIMEOUT		//!< Nothing before the timeout
+	};
+
+	struct Counters
+	{
+		uint64_t pushed;	//!< Samples written by the producer
+		uint64_t overruns;	//!< Samples lost because the ring was full
+		uint64_t dropped;	//!< Samples skipped by a latest-only read or overwritten on a full ring
+		uint64_t popped;	//!< Samples delivered to the consumer
+	};
+
+	/**
+	* Constructor
+	* @param capacity Number of samples, rounded up to a power of two
+	* @param nbChannel Number of values per sample
+	*/
+	EMGSampleRing(size_t capacity, size_t nbChannel);
+
+	/**
+	* Producer: copy a sample into the ring.
+	* @param published Publish time, returned by getLastPublished() once the sample is read
+	* @return false if the ring is full (overrun), never with enableOverwrite()
+	*/
+	bool push(const double* data, double time, uint64_t sequence, double published = 0.0);
+
+	/**
+	* Let push() wake up a consumer sleeping in waitForData(). Set before the threads start,
+	* it adds a full fence to every push.
+	*/
+	void enableWakeup()
+	{
+		wakeup_ = true;
+	}
+
+	/**
+	* Overwrite the oldest sample when the ring is full instead of rejecting the new one.
+	* Set before the threads start; the producer then moves tail_ as well, with a compare and
+	* swap on both sides.
+	*/
+	void enableOverwrite()
+	{
+		overwrite_ = true;
+	}
+
+	/**
+	* Consumer: wait until a sample can be read, polling the head for spinNs then sleeping on
+	* the futex word. Needs enableWakeup() to sleep, polls for the whole timeout otherwise.
+	* @param timeoutNs Longest wait from the call
+	*/
+	WaitResult waitForData(uint64_t spinNs, uint64_t timeoutNs);
+
+	/**
+	* Consumer: read the oldest sample.
+	* @return false if the ring is empty, the outputs are untouched
+	*/
+	bool readOldest(double* data, double& time, uint64_t& sequence);
+
+	/**
+	* Consumer: read the newest sample and discard the older ones.
+	* @return false if the ring is empty, the outputs are untouched
+	*/
+	bool readLatest(double* data, double& time, uint64_t& sequence);
+
+	/**
+	* Consumer: read according to a policy.
+	* @return false if there was no new sample
+	*/
+	bool read(ReadPolicy policy, double* data, double& time, uint64_t& sequence)
+	{
+		return policy == OLDEST_FIRST ? readOldest(data, time, sequence) : readLatest(data, time, sequence);
+	}
+
+	/**
+	* Number of samples waiting to be read, approximate from the producer side.
+	*/
+	size_t size() const
+	{
+		return static_cast<size_t>(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+	}
+
+	/**
+	* Consumer: publish time of the last sample read.
+	*/
+	double getLastPublished() const
+	{
+		return lastPublished_;
+	}
+
+	size_t getCapacity() const
+	{
+		return capacity_;
+	}
+
+	size_t getNbChannel() const
+	{
+		return nbChannel_;
+	}
+
+	/**
+	* Snapshot of the counters, can be called from any thread.
+	*/
+	Counters getCounters() const;
+
+protected:
+
+	struct SlotHeader
+	{
+		double time;
+		uint64_t sequence;
+		double published;
+	};
+
+	char* slot(uint64_t index)
+	{
+		return base_ + (index & mask_) * stride_;
+	}
+
+	void copyOut(uint64_t index, double* data, double& time, uint64_t& sequence);
+
+	/**
+	* Consumer: move tail_ past the samples read.
+	* @return false if the producer overwrote the oldest sample meanwhile, the copy may be torn
+	*/
+	bool advanceTail(uint64_t tail, uint64_t newTail)
+	{
+		if (!overwrite_)
+		{
+			tail_.store(newTail, std::memory_order_release);
+			return true;
+		}
+		return tail_.compare_exchange_strong(tail, newTail, std::memory_order_acq_rel, std::memory_order_relaxed);
+	}
+
+	size_t capacity_;
+	size_t mask_;
+	size_t nbChannel_;
+	size_t stride_;				//!< Slot size in bytes, multiple of CACHE_LINE
+	std::vector<char> storage_;
+	char* base_;				//!< storage_ aligned on CACHE_LINE
+
+	alignas(CACHE_LINE) std::atomic<uint64_t> head_;	//!< Next slot written, owned by the producer
+	std::atomic<uint64_t> pushed_;
+	std::atomic<uint64_t> overruns_;
+	std::atomic<uint64_t> overwritten_;						//!< Oldest samples dropped by push() with overwrite_
+	uint64_t tailCache_;									//!< Producer copy of tail_
+	bool overwrite_;										//!< A full ring drops its oldest sample
+
+	alignas(CACHE_LINE) std::atomic<uint64_t> tail_;	//!< Next slot read, owned by the consumer
+	std::atomic<uint64_t> dropped_;
+	std::atomic<uint64_t> popped_;
+	uint64_t headCache_;									//!< Consumer copy of head_
+	double lastPublished_;									//!< Publish time of the last sample read
+
+	alignas(CACHE_LINE) bool wakeup_;					//!< push() checks waiting_
+	std::atomic<uint32_t> waiting_;							//!< Set by the consumer before it sleeps
+	std::atomic<uint32_t> signal_;							//!< Futex word, bumped by push() when waiting_ is set
+};
+
+#endif
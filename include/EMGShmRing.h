@@ -0,0 +1,198 @@
+#ifndef EMG_SHM_RING_H_
+#define EMG_SHM_RING_H_
+
+/*
+* Shared-memory sample ring between a local EMG producer and the plugin, C header
+* usable by C and C++ producers (python/emg_shm.py is the Python equivalent).
+*
+* The plugin creates the POSIX shared memory object /<name> (<source>shm</source>),
+* the producer maps it and writes samples without any system call. Little-endian,
+* offsets in bytes:
+*
+*   0    uint32  magic "EMGS"
+*   4    uint16  version (1)
+*   6    uint16  channel count
+*   8    uint32  capacity, samples, power of two
+*   12   uint32  slot size, bytes, multiple of 64
+*   16   uint32  consumer waiting: the plugin sleeps on the futex word, wake it after a write
+*   64   uint64  write index: samples written since the creation (producer cache line)
+*   128  uint32  futex word, incremented by the producer before a wake (wake cache line)
+*   192  slots, capacity times slot size
+*
+* Slot of the sample of index n, at 192 + (n % capacity) * slot size:
+*
+*   0    uint64  stamp: 2n + 1 while being written, 2n + 2 once complete
+*   8    uint32  sequence number of the sample
+*   12   uint32  reserved
+*   16   uint64  write time, CLOCK_MONOTONIC ns, for the transport latency
+*   24   float64 time stamp of the sample, seconds
+*   32   float64 values, channel count
+*
+* Single producer. The producer never waits: when the plugin is more than capacity
+* samples behind, the oldest samples are overwritten and counted as overruns by the plugin.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define EMG_SHM_MAGIC 0x53474D45u /* "EMGS" in memory order */
+#define EMG_SHM_VERSION 1
+#define EMG_SHM_WRITE_INDEX_OFFSET 64
+#define EMG_SHM_FUTEX_OFFSET 128
+#define EMG_SHM_SLOTS_OFFSET 192
+#define EMG_SHM_SLOT_HEADER 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct EMGShmHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t nbChannel;
+	uint32_t capacity;
+	uint32_t slotSize;
+	uint32_t consumerWaiting;
+} EMGShmHeader;
+
+typedef struct EMGShmSlot
+{
+	uint64_t stamp;
+	uint32_t sequence;
+	uint32_t reserved;
+	uint64_t writeNs;
+	double time;
+	/* double values[nbChannel] follow */
+} EMGShmSlot;
+
+/* Producer side of a mapped ring */
+typedef struct EMGShmProducer
+{
+	unsigned char* base;
+	size_t size;
+	uint64_t next;	/* Index of the next sample written */
+} EMGShmProducer;
+
+static inline size_t emg_shm_slot_size(size_t nbChannel)
+{
+	return (EMG_SHM_SLOT_HEADER + nbChannel * sizeof(double) + 63) & ~(size_t)63;
+}
+
+static inline size_t emg_shm_size(size_t nbChannel, size_t capacity)
+{
+	return EMG_SHM_SLOTS_OFFSET + capacity * emg_shm_slot_size(nbChannel);
+}
+
+static inline EMGShmHeader* emg_shm_header(unsigned char* base)
+{
+	return (EMGShmHeader*)base;
+}
+
+static inline uint64_t* emg_shm_write_index(unsigned char* base)
+{
+	return (uint64_t*)(base + EMG_SHM_WRITE_INDEX_OFFSET);
+}
+
+static inline uint32_t* emg_shm_futex(unsigned char* base)
+{
+	return (uint32_t*)(base + EMG_SHM_FUTEX_OFFSET);
+}
+
+static inline EMGShmSlot* emg_shm_slot(unsigned char* base, uint64_t index)
+{
+	const EMGShmHeader* header = emg_shm_header(base);
+	return (EMGShmSlot*)(base + EMG_SHM_SLOTS_OFFSET + (index & (header->capacity - 1)) * header->slotSize);
+}
+
+#ifdef __linux__
+static inline uint64_t emg_shm_now_ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/*
+* Map the ring the plugin created. Returns 0 on success, -1 if it does not exist (yet)
+* or does not have nbChannel channels.
+*/
+static inline int emg_shm_attach(EMGShmProducer* producer, const char* name, size_t nbChannel)
+{
+	struct stat info;
+	const int fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < EMG_SHM_SLOTS_OFFSET)
+	{
+		close(fd);
+		return -1;
+	}
+	producer->size = (size_t)info.st_size;
+	producer->base = (unsigned char*)mmap(NULL, producer->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (producer->base == (unsigned char*)MAP_FAILED)
+		return -1;
+
+	const EMGShmHeader* header = emg_shm_header(producer->base);
+	if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != EMG_SHM_MAGIC || header->version != EMG_SHM_VERSION ||
+		header->nbChannel != nbChannel || producer->size < emg_shm_size(nbChannel, header->capacity))
+	{
+		munmap(producer->base, producer->size);
+		return -1;
+	}
+	producer->next = __atomic_load_n(emg_shm_write_index(producer->base), __ATOMIC_ACQUIRE);
+	return 0;
+}
+
+static inline void emg_shm_detach(EMGShmProducer* producer)
+{
+	munmap(producer->base, producer->size);
+	producer->base = NULL;
+}
+
+/*
+* Publish one sample of every channel. No system call unless the plugin sleeps.
+*/
+static inline void emg_shm_write(EMGShmProducer* producer, const double* values, uint32_t sequence, double time)
+{
+	unsigned char* base = producer->base;
+	const uint64_t index = producer->next;
+	EMGShmSlot* slot = emg_shm_slot(base, index);
+
+	__atomic_store_n(&slot->stamp, 2 * index + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	slot->sequence = sequence;
+	slot->writeNs = emg_shm_now_ns();
+	slot->time = time;
+	memcpy(slot + 1, values, emg_shm_header(base)->nbChannel * sizeof(double));
+	__atomic_store_n(&slot->stamp, 2 * index + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(emg_shm_write_index(base), index + 1, __ATOMIC_RELEASE);
+	producer->next = index + 1;
+
+	/* Full barrier: the write index store is ordered before the read of the waiting flag */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&emg_shm_header(base)->consumerWaiting, __ATOMIC_RELAXED))
+	{
+		__atomic_add_fetch(emg_shm_futex(base), 1, __ATOMIC_RELEASE);
+		syscall(SYS_futex, emg_shm_futex(base), FUTEX_WAKE, 1, NULL, NULL, 0);
+	}
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
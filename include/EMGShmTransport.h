@@ -0,0 +1,80 @@
+#ifndef EMG_SHM_TRANSPORT_H_
+#define EMG_SHM_TRANSPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+* Consumer side of the shared-memory sample ring of EMGShmRing.h, for a producer
+* running on the same host. Reading is a few loads and a copy, without system call;
+* wait() polls for a bounded time, then sleeps on the futex word of the ring.
+* Receive thread only, except wake().
+*/
+class EMGShmTransport
+{
+public:
+	struct Counters
+	{
+		uint64_t samples;	//!< Samples read
+		uint64_t overruns;	//!< Samples overwritten by the producer before being read
+		uint64_t sleeps;	//!< futex waits, the producer made a system call to wake each one
+	};
+
+	EMGShmTransport();
+	~EMGShmTransport();
+
+	/**
+	* Create the shared memory object, or reuse it if a previous run left a ring with
+	* the same layout, so that an attached producer keeps working across restarts.
+	* @param name POSIX shared memory name, "/emg_udp_simulink"
+	* @param capacity Samples, rounded up to a power of two
+	* @return false with errno set on failure
+	*/
+	bool create(const std::string& name, size_t nbChannel, size_t capacity);
+
+	/**
+	* Read the next sample, the oldest not yet read.
+	* @param writeNs CLOCK_MONOTONIC time of the write, in ns
+	* @return false if the producer has not written a new sample
+	*/
+	bool read(double* data, uint32_t& sequence, double& time, uint64_t& writeNs);
+
+	/**
+	* Return when a sample is available, after wake(), or after timeoutMs.
+	* @param spinNs Polling time before sleeping on the futex
+	*/
+	void wait(uint64_t spinNs, int timeoutMs);
+
+	/**
+	* Wake up wait(), from any thread.
+	*/
+	void wake();
+
+	/**
+	* Unmap the ring. The object is kept for the next run, see create().
+	*/
+	void close();
+
+	const Counters& getCounters() const
+	{
+		return counters_;
+	}
+
+	/**
+	* CLOCK_MONOTONIC in ns, the clock of the write times.
+	*/
+	static uint64_t nowNs();
+
+protected:
+	bool available() const;
+
+	unsigned char* base_;
+	size_t size_;
+	size_t nbChannel_;
+	uint64_t capacity_;
+	uint64_t readIndex_;	//!< Index of the next sample to read
+	Counters counters_;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef EMG_TELEMETRY_H_
+#define EMG_TELEMETRY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+
+/**
+* Live monitoring output: processed samples sent as UDP datagrams by a background thread.
+*
+* Datagram, in host byte order (little-endian on x86-64 and ARM):
+*   offset  size  field
+*   0       4     magic 'EMGT' (0x54474D45)
+*   4       2     version (1)
+*   6       2     nbChannel N
+*   8       8     sequence of the sample (uint64)
+*   16      8     sample time in seconds (float64)
+*   24      64    health counters (uint64), see Health
+*   88      8N    normalized values (float64)
+*   88+8N   8N    maxEMG used for the normalization (float64)
+*
+* push() copies the sample into a fixed ring of slots and returns, without lock or
+* system call. When the sender falls behind, the oldest samples are overwritten:
+* the monitor gets the newest data and the receive thread never waits for it.
+*/
+class EMGTelemetry
+{
+public:
+	static const uint32_t MAGIC = 0x54474D45;
+	static const uint16_t VERSION = 1;
+	static const size_t HEADER_SIZE = 88;
+	static const size_t MAX_DATAGRAM = 65507;	//!< Largest UDP payload, 4088 channels
+
+	/**
+	* Receive path counters sent with each sample, cumulative since init().
+	*/
+	struct Health
+	{
+		uint64_t received;		//!< Datagrams given to the decoder
+		uint64_t malformed;		//!< Datagrams skipped by the decoder
+		uint64_t sequenceGaps;	//!< Packets missing according to the sequence numbers
+		uint64_t lost;			//!< Samples the reorder buffer gave up on
+		uint64_t overruns;		//!< Samples lost because the sample ring was full
+		uint64_t dropped;		//!< Samples skipped by the latest-only read policy
+		uint64_t deadlineMisses;	//!< Pull mode reads without a new sample
+		uint64_t overwritten;	//!< Telemetry samples overwritten before being sent, filled in by the sender
+	};
+
+	struct Counters
+	{
+		uint64_t sent;			//!< Datagrams sent
+		uint64_t overwritten;	//!< Samples overwritten before the sender read them
+		uint64_t errors;		//!< Failed sends (no route, full socket buffer)
+	};
+
+	/**
+	* @param capacity Samples buffered between the receive thread and the sender, rounded up to a power of two
+	*/
+	EMGTelemetry(size_t capacity = 256);
+	~EMGTelemetry();
+
+	/**
+	* Open the socket and start the sender thread.
+	* @param decimation One sample out of decimation is sent
+	* @return false if the address is invalid, the socket cannot be created or the datagram would be too large
+	*/
+	bool start(const std::string& ip, int port, size_t nbChannel, size_t decimation);
+
+	/**
+	* Send the queued samples and stop the sender thread.
+	*/
+	void stop();
+
+	bool isEnabled() const
+	{
+		return running_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* Receive thread: count a published sample.
+	* @return true if this sample is to be sent, every <decimation> samples
+	*/
+	bool tick()
+	{
+		if (++ticks_ < decimation_)
+			return false;
+		ticks_ = 0;
+		return true;
+	}
+
+	/**
+	* Receive thread: queue one sample, never blocks.
+	* @param normalized nbChannel normalized values
+	* @param maxAmp nbChannel maxEMG values
+	*/
+	void push(const double* normalized, const double* maxAmp, double time, uint64_t sequence, const Health& health);
+
+	/**
+	* Snapshot of the counters, can be called from any thread.
+	*/
+	Counters getCounters() const;
+
+protected:
+	struct SlotHeader
+	{
+		uint64_t stamp;		//!< 2 * index + 1 while written, 2 * index + 2 once complete
+		uint64_t sequence;
+		double time;
+		Health health;
+	};
+
+	unsigned char* slot(uint64_t index)
+	{
+		return &slots_[(index & (capacity_ - 1)) * slotSize_];
+	}
+
+	void senderLoop();
+	size_t drain();
+	bool read();
+
+	size_t capacity_;
+	size_t nbChannel_;
+	size_t slotSize_;
+	size_t decimation_;
+	size_t ticks_;
+	std::vector<unsigned char> slots_;
+	std::atomic<uint64_t> writeIndex_;		//!< Next slot written, owned by the receive thread
+	uint64_t readIndex_;					//!< Next slot sent, owned by the sender thread
+	std::vector<unsigned char> datagram_;
+	int sockFd_;
+	struct sockaddr_in address_;			//!< Monitor address
+	std::atomic<bool> running_;
+	std::atomic<uint64_t> sent_;
+	std::atomic<uint64_t> overwritten_;
+	std::atomic<uint64_t> errors_;
+	std::thread senderThread_;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef EMG_TEXT_PARSER_H_
+#define EMG_TEXT_PARSER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+* In-place parser for the bracketed ASCII format ["v1","v2",...].
+*
+* Accepts exactly the inputs of the former std::istringstream based parser:
+* the content between the first '[' and the last ']' is split on whitespace,
+* '"' and ',' and parsed as doubles (C locale) until the first invalid token.
+* The datagram is scanned in place: no std::string, no copy, no allocation.
+* Errors are counted instead of being printed from the receive thread.
+*/
+class EMGTextParser
+{
+public:
+	/**
+	* Per-packet error counters, only written by the thread calling parse().
+	*/
+	struct Counters
+	{
+		uint64_t packets;		//!< Datagrams given to parse()
+		uint64_t malformed;		//!< Missing or inverted brackets, packet skipped
+		uint64_t incomplete;	//!< Fewer values than channels, missing ones set to 0
+		uint64_t invalidValues;	//!< Parsing stopped on a token that is not a number
+	};
+
+	EMGTextParser();
+
+	/**
+	* Parse a datagram.
+	* @param buffer Received datagram, does not need to be null-terminated
+	* @param size Size of the datagram in bytes, parsing also stops at the first '\0'
+	* @param data Output array of nbChannel values, missing values are set to 0
+	* @param nbChannel Number of channels expected (subject XML)
+	* @return false if the datagram is malformed and must be skipped
+	*/
+	bool parse(const char* buffer, size_t size, double* data, size_t nbChannel);
+
+	/**
+	* Read the optional sequence number in front of the values: 123["v1","v2",...].
+	* parse() ignores everything before the '[', senders without a sequence stay compatible.
+	* @return false if there is no unsigned decimal number before the '['
+	*/
+	static bool parseSequence(const char* buffer, size_t size, uint32_t& sequence);
+
+	/**
+	* Format a text packet ["v1","v2",...], used by the replay source and the test senders.
+	* Shortest representation that parses back to the same double.
+	* @param sequence Sequence number written in front of the values, none if negative
+	* @return Size of the packet in bytes, 0 if the buffer is too small
+	*/
+	static size_t format(char* buffer, size_t bufferSize, const double* data, size_t nbChannel, int64_t sequence = -1);
+
+	const Counters& getCounters() const
+	{
+		return counters_;
+	}
+
+	void resetCounters();
+
+protected:
+
+	/**
+	* Parse one number starting at begin, same grammar as std::num_get<char> for double.
+	* @param end End of the parsed region, must point to a non-numeric character or the region end
+	* @return Pointer past the number, nullptr if there is no valid number at begin
+	*/
+	static const char* parseNumber(const char* begin, const char* end, double& value);
+
+	Counters counters_;
+};
+
+#endif
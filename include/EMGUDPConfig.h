@@ -0,0 +1,175 @@
+#ifndef EMG_UDP_CONFIG_H_
+#define EMG_UDP_CONFIG_H_
+
+#include <string>
+#include <vector>
+
+#include "EMGSampleRing.h"
+#include "EMGAmplitudeCalibrator.h"
+#include "EMGFanIn.h"
+#include "EMGReorderBuffer.h"
+
+/**
+* Plugin specific settings read from executionEMG.xml.
+* ExecutionEmgXml only exposes the ip, port and maxEMG elements, so the optional
+* elements used by this plugin are read here. Every element is optional and
+* falls back to the default set in the constructor.
+*/
+class EMGUDPConfig
+{
+public:
+	/**
+	* Wire format of the UDP datagrams.
+	*/
+	enum PacketFormat
+	{
+		TEXT,	//!< Bracketed ASCII list: ["v1","v2",...]
+		BINARY,	//!< Fixed-layout binary packet, see EMGBinaryPacket.h
+		AUTO	//!< Binary when the magic number matches, text otherwise
+	};
+
+	/**
+	* How datagrams are read from the socket.
+	*/
+	enum ReceiveMode
+	{
+		SINGLE,	//!< One recvfrom() per datagram, time stamped before the call
+		BATCH	//!< recvmmsg() drains the socket per wakeup, kernel time stamps
+	};
+
+	/**
+	* Rate conversion between the sender and GetDataMap().
+	*/
+	enum Resampling
+	{
+		RESAMPLE_NONE,		//!< One sample per packet
+		RESAMPLE_MEAN,		//!< Mean of the samples received since the last read
+		RESAMPLE_MAX,		//!< Max of the samples received since the last read
+		RESAMPLE_DECIMATE	//!< Anti-aliased decimation by <decimation> in the receive thread
+	};
+
+	/**
+	* How the normalization amplitude (maxEMG) is obtained.
+	*/
+	enum CalibrationMode
+	{
+		CALIBRATION_RUNNING,	//!< Running max of every sample, saved on stop (former behaviour)
+		CALIBRATION_CALIBRATE,	//!< Robust MVC estimation from the start, saved on stop
+		CALIBRATION_FROZEN		//!< maxEMG of the XML is used as is and never written back
+	};
+
+	/**
+	* File written when recording is enabled (setRecord()).
+	*/
+	enum RecordFormat
+	{
+		RECORD_STO,		//!< OpenSimFileLogger, normalized values only
+		RECORD_BINARY	//!< Chunked .emgrec file written by a background thread, raw and normalized values
+	};
+
+	/**
+	* Where the samples come from.
+	*/
+	enum Source
+	{
+		SOURCE_UDP,		//!< Live sender on ip:port
+		SOURCE_REPLAY,	//!< Recorded session (.sto or .emgrec), <replay><file>
+		SOURCE_SHM		//!< Local producer writing the shared-memory ring of EMGShmRing.h, <shm><name>
+	};
+
+	/**
+	* One sender of a multi-source setup and the channels it sends, in packet order.
+	*/
+	struct Endpoint
+	{
+		std::string ip;
+		int port;
+		std::vector<std::string> channels; //!< Channel names of the subject XML
+	};
+
+	/**
+	* Weights of one channel of the subject XML in the mixing matrix.
+	*/
+	struct MixingRow
+	{
+		std::string channel;	//!< Channel name of the subject XML
+		std::string weights;	//!< Weights of the received channels, see EMGMixer::setRow()
+	};
+
+	/**
+	* Constructor, set the default values
+	*/
+	EMGUDPConfig();
+
+	/**
+	* Read the optional elements from the execution EMG XML.
+	* Unknown or missing elements are ignored.
+	* @param fileName executionEMG.xml file name
+	*/
+	void read(const std::string& fileName);
+
+	/**
+	* Print the configuration to the console.
+	*/
+	void print() const;
+
+	PacketFormat packetFormat; //!< <packetFormat>text|binary|auto</packetFormat>
+	ReceiveMode receiveMode; //!< <receiveMode>single|batch</receiveMode>
+	int batchSize; //!< <batchSize>, maximum datagrams per recvmmsg() call
+	int rcvBuf; //!< <rcvBuf>, socket receive buffer in bytes, 0 keeps the system default
+	int maxDatagram; //!< <maxDatagram>, largest datagram received in bytes, larger ones are dropped
+	double fragmentTimeout; //!< <fragments><timeout>, wait for the missing fragments of a frame, ms in the XML, seconds here
+	EMGSampleRing::ReadPolicy readPolicy; //!< <readPolicy>latest|oldest|hold</readPolicy>, what GetDataMap() returns
+	int ringSize; //!< <ringSize>, samples buffered between the feeder thread and GetDataMap()
+	double pullDeadline; //!< <pull><deadline>, GetDataMap() waits up to this for a new sample, ms in the XML, seconds here, 0 never waits
+	int pullSpin; //!< <pull><spin>, microseconds of polling before sleeping on the futex
+	bool conditioning; //!< <conditioning>true</conditioning>, filter raw EMG in the plugin
+	std::vector<double> dcACoeff; //!< <dcFilter><aCoeff>
+	std::vector<double> dcBCoeff; //!< <dcFilter><bCoeff>
+	std::vector<double> hpACoeff; //!< <hpFilter><aCoeff>
+	std::vector<double> hpBCoeff; //!< <hpFilter><bCoeff>
+	std::vector<double> lpACoeff; //!< <lpFilter><aCoeff>
+	std::vector<double> lpBCoeff; //!< <lpFilter><bCoeff>
+	Resampling resampling; //!< <resampling>none|mean|max|decimate</resampling>
+	int decimation; //!< <decimation>, decimation factor, sender rate / model rate
+	int decimationTaps; //!< <decimationTaps>, FIR length of the decimator, 0 for 8 * decimation + 1
+	CalibrationMode calibrationMode; //!< <calibration><mode>running|calibrate|frozen</mode>
+	EMGAmplitudeCalibrator::Method calibrationMethod; //!< <calibration><method>rms|abs</method>
+	int calibrationWindow; //!< <calibration><window>, RMS window in samples
+	double calibrationPercentile; //!< <calibration><percentile>, quantile used as MVC, 1 for the maximum
+	double calibrationOutlierFactor; //!< <calibration><outlierFactor>, 0 disables the outlier clipping
+	double calibrationDuration; //!< <calibration><duration>, seconds of samples before the estimate is frozen, 0 until stopCalibration()
+	RecordFormat recordFormat; //!< <recordFormat>sto|binary</recordFormat>
+	Source source; //!< <source>udp|replay|shm</source>
+	std::string replayFile; //!< <replay><file>, recording replayed in replay mode
+	double replaySpeed; //!< <replay><speed>, 1 for real time, N for N times faster, 0 for as fast as possible
+	bool replayLoop; //!< <replay><loop>, restart at the end of the file
+	std::string shmName; //!< <shm><name>, POSIX shared memory object of the shm source
+	int shmCapacity; //!< <shm><capacity>, samples of the shared-memory ring
+	int shmSpin; //!< <shm><spin>, microseconds of polling before sleeping on the futex
+	std::string telemetryIp; //!< <telemetry><ip>, address of the monitor
+	int telemetryPort; //!< <telemetry><port>, UDP port of the monitor, 0 disables the telemetry
+	int telemetryDecimation; //!< <telemetry><decimation>, one published sample out of decimation is sent
+	std::string metricsFile; //!< <metrics><file>, periodic metrics summary, empty for none
+	double metricsPeriod; //!< <metrics><period>, seconds between two rows of the summary
+	std::vector<int> realtimeCpus; //!< <realtime><cpu>, CPUs of the receive thread, empty for no pinning
+	int realtimePriority; //!< <realtime><priority>, SCHED_FIFO priority of the receive thread, 0 keeps the default scheduler
+	bool realtimeLockMemory; //!< <realtime><lockMemory>, mlockall and stack prefault
+	int busyPoll; //!< <realtime><busyPoll>, SO_BUSY_POLL in microseconds, 0 disables
+	bool spin; //!< <realtime><spin>, poll the socket without sleeping instead of waiting in epoll
+	std::vector<Endpoint> endpoints; //!< <endpoints><endpoint>, several senders merged, empty for the single ip:port
+	EMGFanIn::Alignment fanInAlignment; //!< <fanIn><alignment>sequence|time</alignment>
+	double fanInTolerance; //!< <fanIn><tolerance>, sender time difference of one frame, ms in the XML, seconds here
+	EMGFanIn::StallPolicy fanInStallPolicy; //!< <fanIn><stallPolicy>hold|zero|drop</stallPolicy>
+	double fanInTimeout; //!< <fanIn><stallTimeout>, ms in the XML, seconds here
+	int reorderWindow; //!< <reorder><window>, samples put back in sequence order, 0 disables the reorder buffer
+	double reorderMaxDelay; //!< <reorder><maxDelay>, wait for a missing sample, ms in the XML, seconds here
+	EMGReorderBuffer::GapFill reorderGapFill; //!< <reorder><gapFill>hold|linear|nan</gapFill>
+	bool clockSync; //!< <clock><sync>, time stamp the samples with their sender time mapped to the host clock
+	double clockWindow; //!< <clock><window>, sender time covered by the offset and drift fit, seconds
+	int mixingInputs; //!< <mixing><inputs>, channels received and mixed into the subject XML channels, 0 disables the mixing
+	std::string mixingFile; //!< <mixing><file>, matrix file, one "<channel> <weights>" line per subject XML channel
+	std::vector<MixingRow> mixingRows; //!< <mixing><row>, rows given in the XML, applied after the file
+};
+
+#endif
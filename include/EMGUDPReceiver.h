@@ -0,0 +1,79 @@
+#ifndef EMG_UDP_RECEIVER_H_
+#define EMG_UDP_RECEIVER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <sys/uio.h>
+#include <time.h>
+
+/**
+* Batched datagram reception.
+* Drains every datagram queued on the socket with one recvmmsg() call per wakeup
+* into a preallocated ring of buffers, each datagram carries its kernel receive
+* time (SO_TIMESTAMPNS) converted to the rtb::getTime() time base.
+*/
+class EMGUDPReceiver
+{
+public:
+	/**
+	* One received datagram, valid until the next call to receive().
+	*/
+	struct Datagram
+	{
+		const char* data;	//!< Null-terminated datagram
+		size_t size;		//!< Size in bytes, without the terminating '\0'
+		double time;		//!< Kernel receive time in the rtb::getTime() time base
+		bool truncated;		//!< Larger than the buffer, size is the size on the wire
+	};
+
+	/**
+	* Constructor
+	* @param batchSize Maximum number of datagrams read per wakeup
+	* @param bufferSize Size of each datagram buffer in bytes
+	*/
+	EMGUDPReceiver(size_t batchSize = 32, size_t bufferSize = 1024);
+
+	/**
+	* Enable kernel timestamps on the socket.
+	* @return false if SO_TIMESTAMPNS is not supported, receive time is then taken after the wakeup
+	*/
+	bool enableTimestamps(int sockFd);
+
+	/**
+	* Read all the queued datagrams, up to the batch size. Blocks for the first one
+	* on a blocking socket, fails with EAGAIN when nothing is queued on a non-blocking one.
+	* @return Number of datagrams received, -1 on error (errno is set)
+	*/
+	int receive(int sockFd);
+
+	const Datagram& operator[](size_t i) const
+	{
+		return datagrams_[i];
+	}
+
+	size_t getBatchSize() const
+	{
+		return batchSize_;
+	}
+
+protected:
+
+	size_t batchSize_;
+	size_t bufferSize_;
+	bool timestamps_;
+
+	std::vector<char> buffers_;				//!< batchSize_ buffers of bufferSize_ bytes
+	std::vector<char> control_;				//!< Ancillary data (timestamps) per message
+	std::vector<struct iovec> iovecs_;
+	std::vector<struct sockaddr_in> addresses_;
+#if defined(__linux__)
+	std::vector<struct mmsghdr> messages_;
+#endif
+	std::vector<Datagram> datagrams_;
+	size_t controlSize_;
+};
+
+#endif
@@ -27,6 +27,27 @@
 #include <condition_variable>
 #include <getTime.h>
 #include <memory>
+#include <atomic>
+
+#include "EMGUDPConfig.h"
+#include "EMGBinaryPacket.h"
+#include "EMGTextParser.h"
+#include "EMGUDPReceiver.h"
+#include "EMGSampleRing.h"
+#include "EMGSample.h"
+#include "EMGConditioner.h"
+#include "EMGResampler.h"
+#include "EMGAmplitudeCalibrator.h"
+#include "EMGRecorder.h"
+#include "EMGReplaySource.h"
+#include "EMGMetrics.h"
+#include "EMGRealtime.h"
+#include "EMGKernels.h"
+#include "EMGShmTransport.h"
+#include "EMGClockSync.h"
+#include "EMGFrameAssembler.h"
+#include "EMGMixer.h"
+#include "EMGTelemetry.h"
 
 #ifdef WIN32
 class __declspec(dllexport) EMGUDPSimulink : public ProducersPluginVirtual
@@ -64,6 +85,21 @@ public:
 	*/
 	const std::map<std::string, double>& GetDataMap();
 
+	/**
+	* Get the data as a contiguous array in the channel order of the subject XML,
+	* with its time stamp and sequence number. No string lookup, no allocation.
+	* Reads the next sample like GetDataMap(): call one or the other per control tick.
+	*/
+	const EMGSampleView& GetDataVector();
+
+	/**
+	* Get the channel names, in the order of GetDataVector()
+	*/
+	const std::vector<std::string>& GetNameVector()
+	{
+		return nameVect_;
+	}
+
 	/**
 	* Get a set of the channel name
 	*/
@@ -73,16 +109,57 @@ public:
 	}
 
 	/**
-	* Get the time stamp of the EMG capture.
+	* Get the time stamp of the EMG capture: the time of the last published sample,
+	* its sender time mapped to the host clock with <clock><sync>. Lock-free.
 	*/
 	const double& getTime()
 	{
-		timeInitMutex_.lock();
-		timeSafe_ = timenow_;
-		timeInitMutex_.unlock();
+		// With resampling the time stamp is the one of the sample returned by GetDataMap()
+		if (config_.resampling != EMGUDPConfig::RESAMPLE_NONE)
+			return sampleView_.time;
+		timeSafe_ = timenow_.load(std::memory_order_acquire);
 		return timeSafe_;
 	}
 
+	/**
+	* Offset and drift of the sender clock, with <clock><sync>. Lock-free, any thread.
+	*/
+	EMGClockSync::Estimate getClockEstimate() const
+	{
+		return clockSync_.getEstimate();
+	}
+
+	/**
+	* Counters of the sample hand-off between the receive thread and GetDataMap(),
+	* overruns (ring full) and samples dropped by the latest-only read policy.
+	*/
+	EMGSampleRing::Counters getSampleCounters() const
+	{
+		return sampleRing_ ? sampleRing_->getCounters() : EMGSampleRing::Counters();
+	}
+
+	/**
+	* Metrics of the receive path: packet counters, sequence gaps, jitter and the
+	* parse time, receive to publish latency, sample age and inter-arrival histograms.
+	* Lock-free, can be called from any thread.
+	*/
+	EMGMetrics::Snapshot getMetrics() const
+	{
+		return metrics_.snapshot(getSampleCounters());
+	}
+
+	/**
+	* Restart the MVC estimation, maxEMG follows the estimate until stopCalibration()
+	* or for <calibration><duration> seconds of samples.
+	* Only when the calibration mode is not the former running max.
+	*/
+	void startCalibration();
+
+	/**
+	* Freeze maxEMG at the current estimate.
+	*/
+	void stopCalibration();
+
 	void stop();
 
 	void setDirectories(std::string outDirectory, std::string inDirectory = std::string())
@@ -107,6 +184,95 @@ public:
 protected:
 
 	void EMGFeed();
+
+	/**
+	* Multi-sender feeder: one epoll wait on every endpoint socket, samples merged into frames by fanIn_.
+	*/
+	void fanInFeed();
+
+	/**
+	* Create, bind and configure a non-blocking UDP socket.
+	* @return Socket file descriptor, throws on failure
+	*/
+	int openSocket(const std::string& ip, int port);
+
+	/**
+	* Fill mixer_ from <mixing><file> and the <mixing><row> elements, throws on an invalid matrix.
+	*/
+	void setupMixer();
+
+	/**
+	* Replay mode feeder: the recorded samples go through processDatagram() as packets
+	* in the configured format, paced by their recorded time stamps.
+	*/
+	void replayFeed();
+
+	/**
+	* Shared memory feeder: the samples of a local producer are read from shmTransport_
+	* and processed directly, there is no packet to decode.
+	*/
+	void shmFeed();
+
+	/**
+	* Decode, normalize and publish one datagram.
+	* @param emgUDPBuffer Null-terminated datagram
+	* @param bytesRead Size of the datagram
+	* @param timeInitCpy Time stamp of the sample
+	* @param arrivalTime Time the datagram was received, for the metrics
+	*/
+	void processDatagram(const char* emgUDPBuffer, int bytesRead, double timeInitCpy, double arrivalTime);
+
+	/**
+	* Decode one datagram, update the packet metrics and the periodic debug print.
+	* @param data Output array of nbChannel values
+	* @param binaryPacket Set if the datagram was a binary packet, its header is in lastHeader_
+	* @return false if the datagram is malformed and must be skipped
+	*/
+	bool decodeDatagram(const char* emgUDPBuffer, int bytesRead, double arrivalTime, double* data, size_t nbChannel, bool& binaryPacket);
+
+	/**
+	* Condition, calibrate, normalize, publish and record one sample of every channel.
+	* @param tempEMGdata Decoded sample in nameVect_ order, modified in place
+	* @param timeInitCpy Time stamp of the sample
+	* @param sequence Sequence number of the sample
+	* @param arrivalTime Time the sample was received, for the metrics
+	*/
+	void processSample(std::vector<double>& tempEMGdata, double timeInitCpy, uint64_t sequence, double arrivalTime);
+
+	/**
+	* Resample, publish, send to the telemetry and record a normalized sample.
+	* The raw values of the binary recording are expected in recordSample_ already.
+	*/
+	void publishSample(const std::vector<double>& tempEMGdata, double timeInitCpy, uint64_t sequence, double arrivalTime);
+
+	/**
+	* Process the samples reorder_ released, in sequence order. The samples filled with
+	* NaN skip conditioning, calibration and resampling, which they would corrupt.
+	* @param arrivalTime Time the last datagram was received, for the metrics
+	*/
+	void processReordered(double arrivalTime);
+
+	/**
+	* Count a datagram larger than <maxDatagram> as malformed instead of parsing it truncated.
+	* @param size Size of the datagram on the wire
+	*/
+	void datagramTruncated(size_t size, double arrivalTime);
+
+	/**
+	* Apply the <realtime> settings to the calling feeder thread.
+	*/
+	void configureThread();
+
+	/**
+	* Receive thread: queue one published sample out of <telemetry><decimation> for the monitor, never blocks.
+	*/
+	void publishTelemetry(const double* data, double time, uint64_t sequence);
+
+	/**
+	* Append a metrics row to <metrics><file> every <metrics><period>.
+	*/
+	void metricsReport();
+
 	void testConnect()
 	{
 		if (_connect == false)
@@ -128,15 +294,11 @@ protected:
 	std::shared_ptr<std::thread> feederThread; //!< Thread for the filtering of the data
 
 
-	std::mutex DataMutex_; //!< Mutex for the data
-	std::mutex EMGMutex_; //!< Mutex for the Raw EMG data
-	std::mutex timeInitMutex_; //!< Mutex for the Raw EMG data
 	std::mutex loggerMutex_; //!< Mutex for the Raw EMG data
 
 	std::map<std::string, double> _torque;
 
-	bool threadEnd_;
-	bool newData_;
+	std::atomic<bool> threadEnd_; //!< Feeder thread runs while true, read by the spinning receive loop
 
 	std::string _outDirectory;
 	std::string _inDirectory;
@@ -144,8 +306,12 @@ protected:
 	bool _record;
 	bool _connect;
 
-	std::vector<double> dataEMG_;
-	double timenow_;
+	std::unique_ptr<EMGSampleRing> sampleRing_; //!< Hand-off of the processed samples from EMGFeed() to GetDataMap()
+	std::vector<double> dataEMGSafe_; //!< Last sample read by GetDataVector()
+	EMGSampleView sampleView_; //!< View on dataEMGSafe_ returned by GetDataVector()
+	std::vector<double*> mapValues_; //!< Values of mapData_ in nameVect_ order, map nodes never move
+	uint64_t sampleSequence_; //!< Sequence number of the samples without one in the packet
+	std::atomic<double> timenow_; //!< Time of the last published sample, written by the feeder thread
 
 	std::string ip_;
 	int port_;
@@ -156,6 +322,47 @@ protected:
 
 	int emgSockFd;		//EMG socket file descriptor
 
+	EMGUDPConfig config_; //!< Plugin options from executionEMG.xml
+	EMGPacketHeader lastHeader_; //!< Header of the last binary packet received
+	EMGTextParser textParser_; //!< Parser for the text packets, holds the parse error counters
+	std::unique_ptr<EMGUDPReceiver> receiver_; //!< Batched reception, only in batch receive mode
+	int receiveCnt_; //!< Counter for the periodic debug print
+	uint64_t binaryErrors_[EMGBinaryPacket::BAD_FRAGMENT + 1]; //!< Skipped binary packets per decode status, reported by the periodic print
+	EMGConditioner conditioner_; //!< Raw EMG to envelope, when <conditioning> is set
+	EMGKernels::Functions kernels_; //!< Per-sample kernels selected for the channel count in init()
+	EMGDecimator decimator_; //!< Sender rate to model rate, receive thread side
+	std::vector<double> decimatedEMGdata_; //!< Output of decimator_
+	EMGWindowReducer windowReducer_; //!< Mean/max since the last read, GetDataMap() side
+	std::vector<double> windowSample_; //!< Sample read from the ring by the reducer
+	EMGAmplitudeCalibrator calibrator_; //!< MVC estimation, used by the receive thread only
+	std::atomic<bool> calibrating_; //!< maxAmp_ follows calibrator_
+	std::atomic<bool> calibrationReset_; //!< Ask the receive thread to restart calibrator_
+	double calibrationStart_; //!< Time stamp of the first sample of the calibration, NaN before it, receive thread only
+	std::unique_ptr<EMGRecorder> recorder_; //!< Binary recording, <recordFormat>binary</recordFormat>
+	std::vector<double> recordSample_; //!< Raw then normalized values pushed to recorder_
+	EMGReplaySource replaySource_; //!< Recorded session, <source>replay</source>
+	EMGShmTransport shmTransport_; //!< Local producer ring, <source>shm</source>
+	EMGClockSync clockSync_; //!< Sender time to host clock, when <clock><sync> is set
+	EMGMetrics metrics_; //!< Receive path metrics, see getMetrics()
+	EMGTelemetry telemetry_; //!< Processed samples for a monitor, when <telemetry><port> is set
+	EMGSocketWaiter socketWaiter_; //!< epoll wait on the socket, woken up by stop()
+	std::vector<int> endpointFds_; //!< Sockets of <endpoints>, in configuration order
+	std::vector<std::vector<double>> endpointData_; //!< Decoded sample of each endpoint
+	std::vector<uint64_t> endpointPackets_; //!< Packets per endpoint, sequence of the text packets
+	EMGFanIn fanIn_; //!< Merge of the endpoint samples into frames
+	std::vector<double> fanInFrame_; //!< Frame published by fanIn_
+	EMGReorderBuffer reorder_; //!< Sequence order and gap filling, when <reorder><window> is set
+	std::vector<double> reorderSample_; //!< Sample released by reorder_
+	std::vector<double> receiveSample_; //!< Decoded sample of processDatagram(), reused for every datagram
+	std::vector<char> datagramBuffer_; //!< Receive buffer of <maxDatagram> bytes and the terminating '\0'
+	EMGFrameAssembler frameAssembler_; //!< Frames split into several binary packets
+	EMGMixer mixer_; //!< Received channels to subject XML channels, when <mixing><inputs> is set
+	std::vector<double> mixerInput_; //!< Received channels decoded before mixer_
+	std::shared_ptr<std::thread> metricsThread_; //!< Periodic metrics summary, when <metrics><file> is set
+	std::mutex metricsMutex_;
+	std::condition_variable metricsCondition_; //!< Wakes metricsThread_ on stop
+	bool metricsEnd_;
+
     // --- NEW: For maxAmp calibration and normalization ---
     std::vector<double> maxAmp_;            // Stores the maximum amplitude for each EMG channel
     // calibrationMode_ and enableNormalization_ are now implicitly handled
@@ -0,0 +1,100 @@
+"""Producer side of the EMG_UDP_Simulink shared-memory ring (include/EMGShmRing.h).
+
+Start the plugin with <source>shm</source> first, it creates the ring, then:
+
+    from emg_shm import EMGShmProducer
+    producer = EMGShmProducer("/emg_udp_simulink", 16)
+    producer.write(values, sequence, time)
+
+Writes are plain stores into the mapping, without system call unless the plugin sleeps.
+The order of the stores is the program order on x86-64 only: on other architectures
+use the C header. x86-64 may still perform the load of the waiting flag before the
+store of the write index, so a full barrier (a locked compare-exchange, through
+pthread_spin_trylock) separates them; without it the plugin could miss the wake and
+sleep until the timeout of its futex wait.
+"""
+
+import ctypes
+import mmap
+import os
+import platform
+import struct
+import time as _time
+
+MAGIC = 0x53474D45
+VERSION = 1
+WRITE_INDEX_OFFSET = 64
+FUTEX_OFFSET = 128
+SLOTS_OFFSET = 192
+SLOT_HEADER = 32
+
+_HEADER = struct.Struct("<IHHIII")
+_SLOT_HEADER = struct.Struct("<QIIQd")
+_U32 = struct.Struct("<I")
+_U64 = struct.Struct("<Q")
+
+_SYS_FUTEX = {"x86_64": 202, "aarch64": 98}
+_FUTEX_WAKE = 1
+
+
+class EMGShmProducer:
+    """Maps the ring of the plugin and writes samples of nb_channel values."""
+
+    def __init__(self, name="/emg_udp_simulink", nb_channel=16):
+        path = "/dev/shm/" + name.lstrip("/")
+        fd = os.open(path, os.O_RDWR)
+        try:
+            size = os.fstat(fd).st_size
+            self._map = mmap.mmap(fd, size, mmap.MAP_SHARED, mmap.PROT_READ | mmap.PROT_WRITE)
+        finally:
+            os.close(fd)
+        magic, version, channels, capacity, slot_size, _ = _HEADER.unpack_from(self._map, 0)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError(path + " is not an EMG shared memory ring")
+        if channels != nb_channel:
+            raise ValueError("%s has %d channels, not %d" % (path, channels, nb_channel))
+        self.nb_channel = nb_channel
+        self._capacity = capacity
+        self._slot_size = slot_size
+        self._values = struct.Struct("<%dd" % nb_channel)
+        self._next = _U64.unpack_from(self._map, WRITE_INDEX_OFFSET)[0]
+
+        self._futex_address = ctypes.addressof(ctypes.c_char.from_buffer(self._map, FUTEX_OFFSET))
+        self._libc = ctypes.CDLL(None, use_errno=True)
+        self._sys_futex = _SYS_FUTEX.get(platform.machine())
+
+        # Private spin lock, only used for the locked instruction of pthread_spin_trylock
+        self._barrier = ctypes.c_int(0)
+        self._libc.pthread_spin_init.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        self._libc.pthread_spin_trylock.argtypes = [ctypes.c_void_p]
+        self._libc.pthread_spin_unlock.argtypes = [ctypes.c_void_p]
+        self._barrier_address = ctypes.addressof(self._barrier)
+        self._libc.pthread_spin_init(self._barrier_address, 0)
+
+    def write(self, values, sequence, time):
+        """Publish one sample: values of every channel, sequence number, time stamp in seconds."""
+        index = self._next
+        slot = SLOTS_OFFSET + (index & (self._capacity - 1)) * self._slot_size
+        _U64.pack_into(self._map, slot, 2 * index + 1)
+        _SLOT_HEADER.pack_into(self._map, slot, 2 * index + 1, sequence & 0xFFFFFFFF, 0, _time.monotonic_ns(), time)
+        self._values.pack_into(self._map, slot + SLOT_HEADER, *values)
+        _U64.pack_into(self._map, slot, 2 * index + 2)
+        _U64.pack_into(self._map, WRITE_INDEX_OFFSET, index + 1)
+        self._next = index + 1
+
+        # Full barrier, then consumerWaiting: the plugin sleeps on the futex word
+        self._full_barrier()
+        if _U32.unpack_from(self._map, 16)[0]:
+            word = _U32.unpack_from(self._map, FUTEX_OFFSET)[0]
+            _U32.pack_into(self._map, FUTEX_OFFSET, (word + 1) & 0xFFFFFFFF)
+            if self._sys_futex is not None:
+                self._libc.syscall(self._sys_futex, ctypes.c_void_p(self._futex_address), _FUTEX_WAKE, 1, None, None, 0)
+
+    def _full_barrier(self):
+        """Store-load barrier: lock cmpxchg on x86-64, the waiting flag is read after the write index is visible."""
+        self._libc.pthread_spin_trylock(self._barrier_address)
+        self._libc.pthread_spin_unlock(self._barrier_address)
+
+    def close(self):
+        self._futex_address = None
+        self._map.close()
@@ -0,0 +1,68 @@
+"""Monitor side of the EMG_UDP_Simulink telemetry (include/EMGTelemetry.h).
+
+Set <telemetry><port> in executionEMG.xml, then:
+
+    from emg_telemetry import EMGTelemetryListener
+    listener = EMGTelemetryListener(31100)
+    sample = listener.receive()
+    sample["normalized"], sample["maxEMG"], sample["health"]["sequenceGaps"]
+
+or run this file to print the samples: python emg_telemetry.py 31100
+"""
+
+import socket
+import struct
+import sys
+
+MAGIC = 0x54474D45
+VERSION = 1
+HEADER_SIZE = 88
+HEALTH = ("received", "malformed", "sequenceGaps", "lost", "overruns", "dropped", "deadlineMisses", "overwritten")
+
+_HEADER = struct.Struct("<IHHQd8Q")
+
+
+class EMGTelemetryListener:
+    """Receives the telemetry datagrams of the plugin on a UDP port."""
+
+    def __init__(self, port, ip="0.0.0.0"):
+        self._socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self._socket.bind((ip, port))
+
+    def close(self):
+        self._socket.close()
+
+    def receive(self, timeout=None):
+        """Next sample as a dict, None on timeout or for a datagram that is not telemetry."""
+        self._socket.settimeout(timeout)
+        try:
+            data = self._socket.recv(65536)
+        except socket.timeout:
+            return None
+        return decode(data)
+
+
+def decode(data):
+    if len(data) < HEADER_SIZE:
+        return None
+    fields = _HEADER.unpack_from(data, 0)
+    magic, version, nb_channel, sequence, time = fields[:5]
+    if magic != MAGIC or version != VERSION or len(data) != HEADER_SIZE + 16 * nb_channel:
+        return None
+    values = struct.unpack_from("<%dd" % (2 * nb_channel), data, HEADER_SIZE)
+    return {
+        "sequence": sequence,
+        "time": time,
+        "health": dict(zip(HEALTH, fields[5:])),
+        "normalized": values[:nb_channel],
+        "maxEMG": values[nb_channel:],
+    }
+
+
+if __name__ == "__main__":
+    listener = EMGTelemetryListener(int(sys.argv[1]) if len(sys.argv) > 1 else 31100)
+    while True:
+        sample = listener.receive()
+        if sample is not None:
+            print("%d %.6f %s %s" % (sample["sequence"], sample["time"],
+                                     " ".join("%.3f" % value for value in sample["normalized"]), sample["health"]))
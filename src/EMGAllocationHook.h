@@ -0,0 +1,117 @@
+#ifndef EMG_ALLOCATION_HOOK_H_
+#define EMG_ALLOCATION_HOOK_H_
+
+// Replaces the global operator new of an executable to count the heap allocations of the
+// process, the plugin and its threads included, while counting is on. Include it in one
+// source file of the executable only. Not part of the plugin.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace EMGAllocationHook
+{
+	inline std::atomic<bool> counting(false);
+	inline std::atomic<uint64_t> allocations(0);
+
+	inline void* allocate(size_t size, size_t alignment = 0)
+	{
+		if (counting.load(std::memory_order_relaxed))
+			allocations.fetch_add(1, std::memory_order_relaxed);
+		if (size == 0)
+			size = 1;
+		void* p = alignment > alignof(std::max_align_t) ?
+			std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment) : std::malloc(size);
+		if (p == nullptr)
+			throw std::bad_alloc();
+		return p;
+	}
+}
+
+void* operator new(size_t size)
+{
+	return EMGAllocationHook::allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return EMGAllocationHook::allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return EMGAllocationHook::allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return EMGAllocationHook::allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return EMGAllocationHook::allocate(size);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return EMGAllocationHook::allocate(size);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return nullptr;
+	}
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+#endif
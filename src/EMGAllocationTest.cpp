@@ -0,0 +1,174 @@
+// Checks that the streaming path of the plugin does not allocate: after init() and a warmup,
+// text and binary packets are sent to the plugin on loopback, decoded by processDatagram()
+// in the receive thread, and read with GetDataMap(), GetDataVector() and getTime(), while
+// operator new is counted in every thread of the process.
+// Usage: EMGAllocationTest <subject.xml> <execution.xml> <executionEMG.xml> [packets], run by ctest.
+// The execution files are copied to the working directory with the EMG file, ip and port replaced.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EMG_UDP_Simulink.h"
+
+#include "EMGAllocationHook.h"
+
+namespace
+{
+	bool readFile(const std::string& fileName, std::string& content)
+	{
+		std::ifstream file(fileName.c_str());
+		if (!file)
+			return false;
+		std::ostringstream oss;
+		oss << file.rdbuf();
+		content = oss.str();
+		return true;
+	}
+
+	// Replace the content of the first <tag>, or insert the element before the closing tag of the root
+	void setElement(std::string& xml, const std::string& tag, const std::string& value, const std::string& root)
+	{
+		const std::string open = "<" + tag + ">", close = "</" + tag + ">";
+		const size_t begin = xml.find(open);
+		const size_t end = xml.find(close);
+		if (begin != std::string::npos && end != std::string::npos && end > begin)
+			xml.replace(begin + open.size(), end - begin - open.size(), value);
+		else
+			xml.insert(xml.rfind("</" + root + ">"), "  " + open + value + close + "\n");
+	}
+
+	// A port nobody listens on, for the plugin to bind
+	int freePort()
+	{
+		const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t length = sizeof(address);
+		if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+			|| getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+		{
+			if (fd >= 0)
+				close(fd);
+			return -1;
+		}
+		close(fd);
+		return ntohs(address.sin_port);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		std::cout << "Usage: " << argv[0] << " <subject.xml> <execution.xml> <executionEMG.xml> [packets]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const size_t nbPacket = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 2000;
+	const size_t nbWarmup = 200;
+
+	// Loopback copies of the execution files, text and binary packets accepted
+	const int port = freePort();
+	std::string execution, executionEMG;
+	if (port < 0 || !readFile(argv[2], execution) || !readFile(argv[3], executionEMG))
+	{
+		std::cerr << "Cannot read " << argv[2] << " or " << argv[3] << ", or no free UDP port." << std::endl;
+		return EXIT_FAILURE;
+	}
+	const std::string executionFile = "EMGAllocationTest_execution.xml";
+	const std::string executionEMGFile = "EMGAllocationTest_executionEMG.xml";
+	setElement(execution, "EMGDeviceFile", executionEMGFile, "execution");
+	setElement(executionEMG, "ip", "127.0.0.1", "executionEMG");
+	setElement(executionEMG, "port", std::to_string(port), "executionEMG");
+	setElement(executionEMG, "packetFormat", "auto", "executionEMG");
+	std::ofstream(executionFile.c_str()) << execution;
+	std::ofstream(executionEMGFile.c_str()) << executionEMG;
+
+	EMGUDPSimulink emg;
+	ProducersPluginVirtual& plugin = emg;
+	try
+	{
+		plugin.init(argv[1], executionFile);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "Plugin init failed: " << exception.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	const size_t nbChannel = emg.GetNameVector().size();
+
+	const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(static_cast<uint16_t>(port));
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	std::vector<double> values(nbChannel);
+	std::vector<char> packet(64 + 32 * nbChannel);
+	size_t fresh = 0, mapReads = 0, vectorReads = 0;
+	for (size_t i = 0; i < nbWarmup + nbPacket; ++i)
+	{
+		if (i == nbWarmup)
+			EMGAllocationHook::counting = true;
+
+		// Text and binary packets alternately, both with a sequence number
+		for (size_t channel = 0; channel < nbChannel; ++channel)
+			values[channel] = 1.0e-4 * static_cast<double>((i + channel) % 100);
+		const uint32_t sequence = static_cast<uint32_t>(i);
+		const size_t size = i % 2 == 0 ?
+			EMGTextParser::format(packet.data(), packet.size(), values.data(), nbChannel, sequence) :
+			EMGBinaryPacket::encode(packet.data(), packet.size(), values.data(), nbChannel, sequence, 1.0e-3 * i, EMGBinaryPacket::FLOAT64);
+		const double before = plugin.getTime();
+		sendto(fd, packet.data(), size, 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+
+		// Until the receive thread published it, at most 20 ms
+		for (int wait = 0; wait < 200 && plugin.getTime() == before; ++wait)
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+		// Both read paths of CEINMS-RT and of the plugin API
+		const bool counted = i >= nbWarmup;
+		if (i % 4 < 2)
+		{
+			const std::map<std::string, double>& map = plugin.GetDataMap();
+			const bool isFresh = map.size() == nbChannel && plugin.getTime() != before;
+			fresh += counted && isFresh;
+			mapReads += counted;
+		}
+		else
+		{
+			const bool isFresh = emg.GetDataVector().fresh;
+			fresh += counted && isFresh;
+			vectorReads += counted;
+		}
+	}
+	EMGAllocationHook::counting = false;
+	const uint64_t allocations = EMGAllocationHook::allocations.load();
+
+	close(fd);
+	plugin.stop();
+	const EMGMetrics::Snapshot metrics = emg.getMetrics();
+	std::cout << "EMGAllocationTest: " << nbPacket << " packets after the warmup, " << metrics.parsed << " decoded in all, " << fresh << " new samples read ("
+		<< mapReads << " GetDataMap, " << vectorReads << " GetDataVector), " << allocations << " heap allocations after the warmup" << std::endl;
+	if (allocations > 0)
+	{
+		std::cerr << "The streaming path allocated " << allocations << " times." << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (fresh < nbPacket / 2)
+	{
+		std::cerr << "Too few samples read, the streaming path was not exercised." << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
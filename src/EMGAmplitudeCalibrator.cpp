@@ -0,0 +1,228 @@
+#include "EMGAmplitudeCalibrator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Observations before the outlier clipping starts for the |x| amplitude
+	const uint64_t ABSOLUTE_WARMUP = 100;
+}
+
+EMGP2Quantile::EMGP2Quantile()
+{
+	reset(0.5);
+}
+
+void EMGP2Quantile::reset(double quantile)
+{
+	p_ = quantile;
+	count_ = 0;
+	for (int i = 0; i < 5; ++i)
+	{
+		q_[i] = 0.0;
+		n_[i] = i + 1;
+	}
+	np_[0] = 1.0;
+	np_[1] = 1.0 + 2.0 * p_;
+	np_[2] = 1.0 + 4.0 * p_;
+	np_[3] = 3.0 + 2.0 * p_;
+	np_[4] = 5.0;
+	dn_[0] = 0.0;
+	dn_[1] = p_ / 2.0;
+	dn_[2] = p_;
+	dn_[3] = (1.0 + p_) / 2.0;
+	dn_[4] = 1.0;
+}
+
+void EMGP2Quantile::add(double x)
+{
+	if (count_ < 5)
+	{
+		q_[count_] = x;
+		count_++;
+		if (count_ == 5)
+			std::sort(q_, q_ + 5);
+		return;
+	}
+
+	int k;
+	if (x < q_[0])
+	{
+		q_[0] = x;
+		k = 0;
+	}
+	else if (x < q_[1])
+		k = 0;
+	else if (x < q_[2])
+		k = 1;
+	else if (x < q_[3])
+		k = 2;
+	else if (x <= q_[4])
+		k = 3;
+	else
+	{
+		q_[4] = x;
+		k = 3;
+	}
+
+	for (int i = k + 1; i < 5; ++i)
+		n_[i] += 1.0;
+	for (int i = 0; i < 5; ++i)
+		np_[i] += dn_[i];
+
+	for (int i = 1; i < 4; ++i)
+	{
+		const double d = np_[i] - n_[i];
+		if ((d >= 1.0 && n_[i + 1] - n_[i] > 1.0) || (d <= -1.0 && n_[i - 1] - n_[i] < -1.0))
+		{
+			const int sign = d > 0.0 ? 1 : -1;
+			const double candidate = parabolic(i, sign);
+			if (q_[i - 1] < candidate && candidate < q_[i + 1])
+				q_[i] = candidate;
+			else
+				q_[i] = linear(i, sign);
+			n_[i] += sign;
+		}
+	}
+	count_++;
+}
+
+double EMGP2Quantile::parabolic(int i, double d) const
+{
+	return q_[i] + d / (n_[i + 1] - n_[i - 1]) *
+		((n_[i] - n_[i - 1] + d) * (q_[i + 1] - q_[i]) / (n_[i + 1] - n_[i]) +
+		(n_[i + 1] - n_[i] - d) * (q_[i] - q_[i - 1]) / (n_[i] - n_[i - 1]));
+}
+
+double EMGP2Quantile::linear(int i, int d) const
+{
+	return q_[i] + d * (q_[i + d] - q_[i]) / (n_[i + d] - n_[i]);
+}
+
+double EMGP2Quantile::value() const
+{
+	if (count_ >= 5)
+		return q_[2];
+	if (count_ == 0)
+		return 0.0;
+
+	double sorted[5];
+	std::copy(q_, q_ + count_, sorted);
+	std::sort(sorted, sorted + count_);
+	return sorted[static_cast<size_t>(std::floor(p_ * (count_ - 1) + 0.5))];
+}
+
+EMGAmplitudeCalibrator::EMGAmplitudeCalibrator() : method_(WINDOW_RMS), window_(1), percentile_(1.0),
+	outlierFactor_(0.0), nbChannel_(0), row_(0), filled_(0), rejected_(0)
+{
+}
+
+void EMGAmplitudeCalibrator::setup(Method method, size_t window, double percentile, double outlierFactor, size_t nbChannel)
+{
+	method_ = method;
+	window_ = window > 0 ? window : 1;
+	percentile_ = std::min(std::max(percentile, 0.0), 1.0);
+	outlierFactor_ = outlierFactor;
+	nbChannel_ = nbChannel;
+
+	squares_.assign(method_ == WINDOW_RMS ? window_ * nbChannel_ : 0, 0.0);
+	sums_.assign(nbChannel_, 0.0);
+	blockSums_.assign(nbChannel_, 0.0);
+	amplitude_.assign(nbChannel_, 0.0);
+	quantiles_.resize(nbChannel_);
+	max_.assign(nbChannel_, 0.0);
+	accepted_.assign(nbChannel_, 0);
+	reset();
+}
+
+void EMGAmplitudeCalibrator::reset()
+{
+	std::fill(squares_.begin(), squares_.end(), 0.0);
+	std::fill(sums_.begin(), sums_.end(), 0.0);
+	std::fill(blockSums_.begin(), blockSums_.end(), 0.0);
+	std::fill(max_.begin(), max_.end(), 0.0);
+	std::fill(accepted_.begin(), accepted_.end(), 0);
+	for (EMGP2Quantile& quantile : quantiles_)
+		quantile.reset(percentile_);
+	row_ = 0;
+	filled_ = 0;
+	rejected_ = 0;
+}
+
+void EMGAmplitudeCalibrator::update(const double* data, double* maxAmp)
+{
+	if (method_ == WINDOW_RMS)
+	{
+		const bool settled = filled_ >= window_;
+		const double scale = 1.0 / (filled_ < window_ ? filled_ + 1 : window_);
+		double* squares = &squares_[row_ * nbChannel_];
+		for (size_t i = 0; i < nbChannel_; ++i)
+		{
+			double square = data[i] * data[i];
+			if (settled && outlierFactor_ > 0.0)
+			{
+				// Clip against the RMS of the previous window
+				const double bound = outlierFactor_ * outlierFactor_ * sums_[i] / window_;
+				if (square > bound && bound > 0.0)
+				{
+					square = bound;
+					rejected_++;
+				}
+			}
+			sums_[i] += square - squares[i];
+			blockSums_[i] += square;
+			squares[i] = square;
+			amplitude_[i] = std::sqrt(std::max(sums_[i], 0.0) * scale);
+		}
+
+		row_++;
+		if (filled_ < window_)
+			filled_++;
+		if (row_ == window_)
+		{
+			// The rows written since row 0 are now the whole window: their sum, made of additions
+			// of non-negative values only, replaces the running sum and its rounding drift. O(channels).
+			row_ = 0;
+			sums_.swap(blockSums_);
+			std::fill(blockSums_.begin(), blockSums_.end(), 0.0);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < nbChannel_; ++i)
+		{
+			double amplitude = std::fabs(data[i]);
+			if (outlierFactor_ > 0.0 && accepted_[i] >= ABSOLUTE_WARMUP)
+			{
+				const double estimate = percentile_ >= 1.0 ? max_[i] : quantiles_[i].value();
+				const double bound = outlierFactor_ * estimate;
+				if (amplitude > bound && bound > 0.0)
+				{
+					amplitude = bound;
+					rejected_++;
+				}
+			}
+			amplitude_[i] = amplitude;
+		}
+	}
+
+	for (size_t i = 0; i < nbChannel_; ++i)
+	{
+		double estimate;
+		if (percentile_ >= 1.0)
+		{
+			max_[i] = std::max(max_[i], amplitude_[i]);
+			estimate = max_[i];
+		}
+		else
+		{
+			quantiles_[i].add(amplitude_[i]);
+			estimate = quantiles_[i].value();
+		}
+		accepted_[i]++;
+
+		if (estimate > 1.0e-6)
+			maxAmp[i] = estimate;
+	}
+}
@@ -0,0 +1,294 @@
+// Google Benchmark suite of the per-sample kernels of the receive path.
+// The former string based text parsing and branchy normalization loops are kept here
+// as baselines. Run EMGBenchmarks --benchmark_filter=<regex> for a subset.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "EMGBinaryPacket.h"
+#include "EMGConditioner.h"
+#include "EMGKernels.h"
+#include "EMGMetrics.h"
+#include "EMGMixer.h"
+#include "EMGReorderBuffer.h"
+#include "EMGSampleRing.h"
+#include "EMGTextParser.h"
+
+#include "EMGLegacyParser.h"
+
+namespace
+{
+	std::vector<double> randomSample(size_t nbChannel, double low = -1.0, double high = 1.0)
+	{
+		std::mt19937 random(static_cast<unsigned>(nbChannel));
+		std::uniform_real_distribution<double> uniform(low, high);
+		std::vector<double> sample(nbChannel);
+		for (double& value : sample)
+			value = uniform(random);
+		return sample;
+	}
+
+	std::string textPacket(size_t nbChannel)
+	{
+		const std::vector<double> sample = randomSample(nbChannel);
+		std::vector<char> buffer(nbChannel * 32 + 16);
+		const size_t size = EMGTextParser::format(buffer.data(), buffer.size(), sample.data(), nbChannel);
+		return std::string(buffer.data(), size);
+	}
+
+	// Max tracking and normalization of the plugin before EMGKernels
+	void legacyNormalize(std::vector<double>& tempEMGdata, std::vector<double>& maxAmp_)
+	{
+		const int NBOFCHANNEL = tempEMGdata.size();
+		for (int i = 0; i < NBOFCHANNEL; ++i)
+			if (tempEMGdata[i] > maxAmp_[i])
+				maxAmp_[i] = tempEMGdata[i];
+		for (int iLoc = 0; iLoc < NBOFCHANNEL; ++iLoc)
+		{
+			if (maxAmp_[iLoc] > 1.0e-6)
+			{
+				tempEMGdata[iLoc] = tempEMGdata[iLoc] / maxAmp_[iLoc];
+				if (tempEMGdata[iLoc] > 1.0)
+					tempEMGdata[iLoc] = 1.0;
+			}
+			else
+				tempEMGdata[iLoc] = 0.0;
+		}
+	}
+
+	// Samples cycled through by the normalization benchmarks, so the branches are not learned
+	const size_t NB_INPUT = 256;
+
+	std::vector<double> normalizationInput(size_t nbChannel)
+	{
+		std::vector<double> input;
+		for (size_t i = 0; i < NB_INPUT; ++i)
+		{
+			const std::vector<double> sample = randomSample(nbChannel + i, -0.5, 2.0);
+			input.insert(input.end(), sample.begin(), sample.begin() + nbChannel);
+		}
+		return input;
+	}
+}
+
+// --- Decoding ---
+
+static void BM_TextParseLegacy(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	const std::string packet = textPacket(nbChannel);
+	std::vector<double> data(nbChannel);
+	for (auto _ : state)
+	{
+		legacyParse(packet.c_str(), data);
+		benchmark::DoNotOptimize(data.data());
+	}
+	state.SetBytesProcessed(state.iterations() * packet.size());
+}
+BENCHMARK(BM_TextParseLegacy)->Arg(16)->Arg(64)->Arg(256);
+
+static void BM_TextParse(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	const std::string packet = textPacket(nbChannel);
+	std::vector<double> data(nbChannel);
+	EMGTextParser parser;
+	for (auto _ : state)
+	{
+		parser.parse(packet.data(), packet.size(), data.data(), nbChannel);
+		benchmark::DoNotOptimize(data.data());
+	}
+	state.SetBytesProcessed(state.iterations() * packet.size());
+}
+BENCHMARK(BM_TextParse)->Arg(16)->Arg(64)->Arg(256);
+
+static void BM_TextFormat(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	const std::vector<double> sample = randomSample(nbChannel);
+	std::vector<char> buffer(nbChannel * 32 + 16);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(EMGTextParser::format(buffer.data(), buffer.size(), sample.data(), nbChannel));
+		benchmark::ClobberMemory();
+	}
+}
+BENCHMARK(BM_TextFormat)->Arg(16)->Arg(64)->Arg(256);
+
+static void BM_BinaryDecode(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	const EMGBinaryPacket::SampleType sampleType = state.range(1) == 64 ? EMGBinaryPacket::FLOAT64 : EMGBinaryPacket::FLOAT32;
+	const std::vector<double> sample = randomSample(nbChannel);
+	std::vector<char> packet(EMGBinaryPacket::HEADER_SIZE + nbChannel * 8);
+	const size_t size = EMGBinaryPacket::encode(packet.data(), packet.size(), sample.data(), nbChannel, 1, 0.0, sampleType);
+	std::vector<double> data(nbChannel);
+	EMGPacketHeader header;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(EMGBinaryPacket::decode(packet.data(), size, data.data(), nbChannel, header));
+		benchmark::DoNotOptimize(data.data());
+	}
+	state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_BinaryDecode)->ArgNames({ "channels", "bits" })->ArgsProduct({ { 16, 64, 256 }, { 32, 64 } });
+
+// --- Per-sample processing ---
+
+static void BM_NormalizeLegacy(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	const std::vector<double> input = normalizationInput(nbChannel);
+	std::vector<double> data(nbChannel), maxAmp(nbChannel, 1.0);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		std::copy(input.begin() + i * nbChannel, input.begin() + (i + 1) * nbChannel, data.begin());
+		legacyNormalize(data, maxAmp);
+		benchmark::DoNotOptimize(data.data());
+		i = (i + 1) % NB_INPUT;
+	}
+}
+BENCHMARK(BM_NormalizeLegacy)->Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(24);
+
+static void BM_NormalizeKernel(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	const std::vector<double> input = normalizationInput(nbChannel);
+	std::vector<double> data(nbChannel), maxAmp(nbChannel, 1.0);
+	const EMGKernels::Functions kernels = EMGKernels::select(nbChannel);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		std::copy(input.begin() + i * nbChannel, input.begin() + (i + 1) * nbChannel, data.begin());
+		kernels.updateMax(data.data(), maxAmp.data(), nbChannel);
+		kernels.normalize(data.data(), maxAmp.data(), nbChannel);
+		benchmark::DoNotOptimize(data.data());
+		i = (i + 1) % NB_INPUT;
+	}
+	state.SetLabel(kernels.specialization > 0 ? "specialized" : "generic");
+}
+BENCHMARK(BM_NormalizeKernel)->Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(24);
+
+static void BM_Conditioner(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	EMGConditioner conditioner;
+	conditioner.setup({ -0.99 }, { 1.0, -1.0 }, { -1.56, 0.64 }, { 0.8, -1.6, 0.8 }, { -1.96, 0.96 }, { 1.0e-3, 2.0e-3, 1.0e-3 }, nbChannel);
+	std::vector<double> data = randomSample(nbChannel);
+	for (auto _ : state)
+	{
+		conditioner.process(data.data());
+		benchmark::DoNotOptimize(data.data());
+	}
+}
+BENCHMARK(BM_Conditioner)->Arg(16)->Arg(64);
+
+// Row-major product, one dependent sum per output channel
+static void BM_MixerNaive(benchmark::State& state)
+{
+	const size_t nbInput = state.range(0), nbOutput = 64;
+	const std::vector<double> weights = randomSample(nbInput * nbOutput);
+	const std::vector<double> input = randomSample(nbInput);
+	std::vector<double> output(nbOutput);
+	for (auto _ : state)
+	{
+		for (size_t row = 0; row < nbOutput; ++row)
+		{
+			double sum = 0.0;
+			for (size_t column = 0; column < nbInput; ++column)
+				sum += weights[row * nbInput + column] * input[column];
+			output[row] = sum;
+		}
+		benchmark::DoNotOptimize(output.data());
+	}
+}
+BENCHMARK(BM_MixerNaive)->Arg(64)->Arg(256);
+
+// 64 output channels, <density> percent of non-zero weights
+static void BM_Mixer(benchmark::State& state)
+{
+	const size_t nbInput = state.range(0), nbOutput = 64;
+	const size_t step = 100 / state.range(1);
+	EMGMixer mixer;
+	mixer.setup(nbInput, nbOutput);
+	std::string error;
+	for (size_t row = 0; row < nbOutput; ++row)
+	{
+		std::ostringstream weights;
+		for (size_t column = row % step; column < nbInput; column += step)
+			weights << column << ":0.5 ";
+		mixer.setRow(row, weights.str(), error);
+	}
+	mixer.prepare();
+	const std::vector<double> input = randomSample(nbInput);
+	std::vector<double> output(nbOutput);
+	for (auto _ : state)
+	{
+		mixer.process(input.data(), output.data());
+		benchmark::DoNotOptimize(output.data());
+	}
+	state.SetLabel(mixer.isSparse() ? "sparse" : "dense");
+}
+BENCHMARK(BM_Mixer)->ArgNames({ "inputs", "density" })->ArgsProduct({ { 64, 256 }, { 5, 25, 100 } });
+
+// --- Hand-off and bookkeeping ---
+
+static void BM_SampleRingPushRead(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	EMGSampleRing ring(64, nbChannel);
+	const std::vector<double> sample = randomSample(nbChannel);
+	std::vector<double> out(nbChannel);
+	double time;
+	uint64_t sequence = 0;
+	for (auto _ : state)
+	{
+		ring.push(sample.data(), 0.0, sequence, 0.0);
+		ring.read(EMGSampleRing::LATEST, out.data(), time, sequence);
+		benchmark::DoNotOptimize(out.data());
+		sequence++;
+	}
+}
+BENCHMARK(BM_SampleRingPushRead)->Arg(16)->Arg(64);
+
+static void BM_HistogramRecord(benchmark::State& state)
+{
+	EMGHistogram histogram;
+	uint64_t value = 12345;
+	for (auto _ : state)
+	{
+		histogram.record(value);
+		value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+		value >>= 40;
+	}
+}
+BENCHMARK(BM_HistogramRecord);
+
+static void BM_ReorderInOrder(benchmark::State& state)
+{
+	const size_t nbChannel = state.range(0);
+	EMGReorderBuffer reorder;
+	reorder.setup(nbChannel, 16, 0.005, EMGReorderBuffer::HOLD);
+	const std::vector<double> sample = randomSample(nbChannel);
+	std::vector<double> out(nbChannel);
+	double time;
+	uint64_t sequence;
+	bool filled;
+	uint32_t wire = 0;
+	for (auto _ : state)
+	{
+		reorder.push(wire, sample.data(), 0.0, 0.0);
+		while (reorder.pop(out.data(), time, sequence, filled))
+			benchmark::DoNotOptimize(out.data());
+		wire++;
+	}
+}
+BENCHMARK(BM_ReorderInOrder)->Arg(16)->Arg(64);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,228 @@
+#include "EMGBinaryPacket.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	const bool HOST_LITTLE_ENDIAN = false;
+#else
+	const bool HOST_LITTLE_ENDIAN = true;
+#endif
+
+	// Unaligned little-endian loads/stores, memcpy is turned into a single move by the compiler.
+	template<typename T>
+	inline T load(const char* src)
+	{
+		T value;
+		if (HOST_LITTLE_ENDIAN)
+		{
+			std::memcpy(&value, src, sizeof(T));
+		}
+		else
+		{
+			char swapped[sizeof(T)];
+			for (size_t i = 0; i < sizeof(T); ++i)
+				swapped[i] = src[sizeof(T) - 1 - i];
+			std::memcpy(&value, swapped, sizeof(T));
+		}
+		return value;
+	}
+
+	template<typename T>
+	inline void store(char* dst, T value)
+	{
+		if (HOST_LITTLE_ENDIAN)
+		{
+			std::memcpy(dst, &value, sizeof(T));
+		}
+		else
+		{
+			char raw[sizeof(T)];
+			std::memcpy(raw, &value, sizeof(T));
+			for (size_t i = 0; i < sizeof(T); ++i)
+				dst[i] = raw[sizeof(T) - 1 - i];
+		}
+	}
+}
+
+bool EMGBinaryPacket::isBinary(const char* buffer, size_t size)
+{
+	return size >= sizeof(uint32_t) && load<uint32_t>(buffer) == MAGIC;
+}
+
+namespace
+{
+	EMGBinaryPacket::Status decodeHeader(const char* buffer, size_t size, EMGPacketHeader& header, size_t& sampleSize)
+	{
+		if (size < EMGBinaryPacket::HEADER_SIZE)
+			return EMGBinaryPacket::TOO_SHORT;
+
+		header.magic = load<uint32_t>(buffer);
+		if (header.magic != EMGBinaryPacket::MAGIC)
+			return EMGBinaryPacket::BAD_MAGIC;
+		header.version = static_cast<uint8_t>(buffer[4]);
+		if (header.version != EMGBinaryPacket::VERSION)
+			return EMGBinaryPacket::BAD_VERSION;
+		header.sampleType = static_cast<uint8_t>(buffer[5]);
+		header.channelCount = load<uint16_t>(buffer + 6);
+		header.sequence = load<uint32_t>(buffer + 8);
+		header.flags = load<uint32_t>(buffer + 12);
+		header.senderTime = load<double>(buffer + 16);
+
+		if (header.sampleType == EMGBinaryPacket::FLOAT32)
+			sampleSize = sizeof(float);
+		else if (header.sampleType == EMGBinaryPacket::FLOAT64)
+			sampleSize = sizeof(double);
+		else
+			return EMGBinaryPacket::BAD_SAMPLE_TYPE;
+		return EMGBinaryPacket::OK;
+	}
+
+	void decodeSamples(const char* payload, uint8_t sampleType, size_t nbDecoded, double* data)
+	{
+		if (sampleType == EMGBinaryPacket::FLOAT32)
+		{
+			for (size_t i = 0; i < nbDecoded; ++i)
+				data[i] = load<float>(payload + i * sizeof(float));
+		}
+		else if (HOST_LITTLE_ENDIAN)
+		{
+			std::memcpy(data, payload, nbDecoded * sizeof(double));
+		}
+		else
+		{
+			for (size_t i = 0; i < nbDecoded; ++i)
+				data[i] = load<double>(payload + i * sizeof(double));
+		}
+	}
+
+	void encodeHeader(char* buffer, size_t nbChannel, uint32_t sequence, uint32_t flags, double senderTime, EMGBinaryPacket::SampleType sampleType)
+	{
+		store<uint32_t>(buffer, EMGBinaryPacket::MAGIC);
+		buffer[4] = static_cast<char>(EMGBinaryPacket::VERSION);
+		buffer[5] = static_cast<char>(sampleType);
+		store<uint16_t>(buffer + 6, static_cast<uint16_t>(nbChannel));
+		store<uint32_t>(buffer + 8, sequence);
+		store<uint32_t>(buffer + 12, flags);
+		store<double>(buffer + 16, senderTime);
+	}
+
+	void encodeSamples(char* payload, const double* data, size_t nbChannel, EMGBinaryPacket::SampleType sampleType)
+	{
+		for (size_t i = 0; i < nbChannel; ++i)
+		{
+			if (sampleType == EMGBinaryPacket::FLOAT32)
+				store<float>(payload + i * sizeof(float), static_cast<float>(data[i]));
+			else
+				store<double>(payload + i * sizeof(double), data[i]);
+		}
+	}
+}
+
+EMGBinaryPacket::Status EMGBinaryPacket::decode(const char* buffer, size_t size, double* data, size_t nbChannel, EMGPacketHeader& header)
+{
+	size_t sampleSize;
+	const Status status = decodeHeader(buffer, size, header, sampleSize);
+	if (status != OK)
+		return status;
+	if (header.flags & FLAG_FRAGMENT)
+		return FRAGMENT;
+
+	// Trailing bytes or a truncated datagram are not a packet of the layout
+	if (size != HEADER_SIZE + header.channelCount * sampleSize)
+		return BAD_SIZE;
+
+	const size_t nbDecoded = header.channelCount < nbChannel ? header.channelCount : nbChannel;
+	decodeSamples(buffer + HEADER_SIZE, header.sampleType, nbDecoded, data);
+	for (size_t i = nbDecoded; i < nbChannel; ++i)
+		data[i] = 0.0;
+
+	return OK;
+}
+
+EMGBinaryPacket::Status EMGBinaryPacket::decodeFragmentHeader(const char* buffer, size_t size, EMGPacketHeader& header, EMGFragmentHeader& fragment)
+{
+	size_t sampleSize;
+	const Status status = decodeHeader(buffer, size, header, sampleSize);
+	if (status != OK)
+		return status;
+	if (!(header.flags & FLAG_FRAGMENT) || size < HEADER_SIZE + FRAGMENT_HEADER_SIZE)
+		return BAD_FRAGMENT;
+
+	fragment.firstChannel = load<uint16_t>(buffer + HEADER_SIZE);
+	fragment.totalChannels = load<uint16_t>(buffer + HEADER_SIZE + 2);
+	fragment.index = static_cast<uint8_t>(buffer[HEADER_SIZE + 4]);
+	fragment.count = static_cast<uint8_t>(buffer[HEADER_SIZE + 5]);
+	if (fragment.count == 0 || fragment.count > MAX_FRAGMENTS || fragment.index >= fragment.count ||
+		fragment.firstChannel + header.channelCount > fragment.totalChannels)
+		return BAD_FRAGMENT;
+	if (size != HEADER_SIZE + FRAGMENT_HEADER_SIZE + header.channelCount * sampleSize)
+		return BAD_SIZE;
+	return OK;
+}
+
+void EMGBinaryPacket::decodeFragmentSamples(const char* buffer, const EMGPacketHeader& header, const EMGFragmentHeader& fragment,
+	double* frame, size_t nbChannel)
+{
+	if (fragment.firstChannel < nbChannel)
+	{
+		const size_t nbDecoded = std::min<size_t>(header.channelCount, nbChannel - fragment.firstChannel);
+		decodeSamples(buffer + HEADER_SIZE + FRAGMENT_HEADER_SIZE, header.sampleType, nbDecoded, frame + fragment.firstChannel);
+	}
+}
+
+size_t EMGBinaryPacket::encode(char* buffer, size_t bufferSize, const double* data, size_t nbChannel,
+	uint32_t sequence, double senderTime, SampleType sampleType)
+{
+	const size_t sampleSize = sampleType == FLOAT32 ? sizeof(float) : sizeof(double);
+	const size_t packetSize = HEADER_SIZE + nbChannel * sampleSize;
+	if (packetSize > bufferSize || nbChannel > 0xFFFF)
+		return 0;
+
+	encodeHeader(buffer, nbChannel, sequence, 0, senderTime, sampleType);
+	encodeSamples(buffer + HEADER_SIZE, data, nbChannel, sampleType);
+	return packetSize;
+}
+
+size_t EMGBinaryPacket::encodeFragment(char* buffer, size_t bufferSize, const double* frame, size_t firstChannel, size_t nbChannel,
+	size_t totalChannels, size_t index, size_t count, uint32_t sequence, double senderTime, SampleType sampleType)
+{
+	const size_t sampleSize = sampleType == FLOAT32 ? sizeof(float) : sizeof(double);
+	const size_t packetSize = HEADER_SIZE + FRAGMENT_HEADER_SIZE + nbChannel * sampleSize;
+	if (packetSize > bufferSize || totalChannels > 0xFFFF || firstChannel + nbChannel > totalChannels ||
+		count == 0 || count > MAX_FRAGMENTS || index >= count)
+		return 0;
+
+	encodeHeader(buffer, nbChannel, sequence, FLAG_FRAGMENT, senderTime, sampleType);
+	store<uint16_t>(buffer + HEADER_SIZE, static_cast<uint16_t>(firstChannel));
+	store<uint16_t>(buffer + HEADER_SIZE + 2, static_cast<uint16_t>(totalChannels));
+	buffer[HEADER_SIZE + 4] = static_cast<char>(index);
+	buffer[HEADER_SIZE + 5] = static_cast<char>(count);
+	store<uint16_t>(buffer + HEADER_SIZE + 6, 0);
+	encodeSamples(buffer + HEADER_SIZE + FRAGMENT_HEADER_SIZE, frame + firstChannel, nbChannel, sampleType);
+	return packetSize;
+}
+
+size_t EMGBinaryPacket::fragmentChannels(size_t maxSize, SampleType sampleType)
+{
+	const size_t sampleSize = sampleType == FLOAT32 ? sizeof(float) : sizeof(double);
+	return maxSize > HEADER_SIZE + FRAGMENT_HEADER_SIZE ? (maxSize - HEADER_SIZE - FRAGMENT_HEADER_SIZE) / sampleSize : 0;
+}
+
+const char* EMGBinaryPacket::statusString(Status status)
+{
+	switch (status)
+	{
+	case OK: return "ok";
+	case TOO_SHORT: return "datagram shorter than header";
+	case BAD_MAGIC: return "bad magic number";
+	case BAD_VERSION: return "unsupported version";
+	case BAD_SAMPLE_TYPE: return "unknown sample type";
+	case BAD_SIZE: return "datagram size does not match channel count";
+	case FRAGMENT: return "fragment of a multi-datagram frame";
+	case BAD_FRAGMENT: return "invalid fragment header";
+	}
+	return "unknown";
+}
@@ -0,0 +1,148 @@
+#include "EMGClockSync.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Slopes beyond 1000 ppm are not a clock drift but a wrong fit
+	const double MAX_DRIFT = 1.0e-3;
+}
+
+EMGClockSync::EMGClockSync() : window_(0.0), blockDuration_(0.0), resetThreshold_(1.0), started_(false), senderOrigin_(0.0),
+	hostOrigin_(0.0), lastX_(0.0), intercept_(0.0), slope_(1.0), blockStart_(0.0), blockX_(0.0), blockY_(0.0), pointX_(),
+	pointY_(), pointHead_(0), pointCount_(0), samples_(0), resets_(0), version_(0), offset_(0.0), drift_(0.0), delay_(0.0),
+	publishedSamples_(0), publishedResets_(0)
+{
+}
+
+void EMGClockSync::setup(double window, double resetThreshold)
+{
+	window_ = std::max(window, 0.0);
+	blockDuration_ = window_ / NB_BLOCK;
+	resetThreshold_ = resetThreshold;
+	started_ = false;
+	resets_ = 0;
+}
+
+void EMGClockSync::restart(double senderTime, double arrivalTime)
+{
+	if (started_)
+		resets_++;
+	started_ = true;
+	senderOrigin_ = senderTime;
+	hostOrigin_ = arrivalTime;
+	lastX_ = 0.0;
+	intercept_ = 0.0;
+	slope_ = 1.0;
+	blockStart_ = 0.0;
+	blockX_ = 0.0;
+	blockY_ = 0.0;
+	pointHead_ = 0;
+	pointCount_ = 0;
+	samples_ = 0;
+}
+
+double EMGClockSync::map(double senderTime, double arrivalTime)
+{
+	if (!started_)
+		restart(senderTime, arrivalTime);
+	double x = senderTime - senderOrigin_;
+	double y = arrivalTime - hostOrigin_;
+	if (x < lastX_ - blockDuration_ || y - (intercept_ + slope_ * x) > resetThreshold_)
+	{
+		restart(senderTime, arrivalTime);
+		x = 0.0;
+		y = 0.0;
+	}
+	lastX_ = x;
+	samples_++;
+
+	// Smallest delay of the block, compared along the current slope
+	if (x - blockStart_ >= blockDuration_)
+	{
+		pointX_[pointHead_] = blockX_;
+		pointY_[pointHead_] = blockY_;
+		pointHead_ = (pointHead_ + 1) % NB_BLOCK;
+		pointCount_ = std::min(pointCount_ + 1, NB_BLOCK);
+		blockStart_ = x;
+		blockX_ = x;
+		blockY_ = y;
+		fit();
+	}
+	else if (samples_ == 1 || y - slope_ * x < blockY_ - slope_ * blockX_)
+	{
+		blockX_ = x;
+		blockY_ = y;
+	}
+
+	// A sample cannot be acquired after it was received
+	double mapped = intercept_ + slope_ * x;
+	if (mapped > y)
+	{
+		intercept_ = y - slope_ * x;
+		mapped = y;
+	}
+	const double hostTime = hostOrigin_ + mapped;
+	publish(senderTime, hostTime, arrivalTime);
+	return hostTime;
+}
+
+void EMGClockSync::fit()
+{
+	// Least squares slope of the block points, needs two of them
+	if (pointCount_ >= 2)
+	{
+		double meanX = 0.0, meanY = 0.0;
+		for (size_t i = 0; i < pointCount_; ++i)
+		{
+			meanX += pointX_[i];
+			meanY += pointY_[i];
+		}
+		meanX /= pointCount_;
+		meanY /= pointCount_;
+		double sxx = 0.0, sxy = 0.0;
+		for (size_t i = 0; i < pointCount_; ++i)
+		{
+			sxx += (pointX_[i] - meanX) * (pointX_[i] - meanX);
+			sxy += (pointX_[i] - meanX) * (pointY_[i] - meanY);
+		}
+		if (sxx > 0.0)
+			slope_ = std::min(std::max(sxy / sxx, 1.0 - MAX_DRIFT), 1.0 + MAX_DRIFT);
+	}
+
+	// Lower envelope of the points and of the block just started
+	intercept_ = blockY_ - slope_ * blockX_;
+	for (size_t i = 0; i < pointCount_; ++i)
+		intercept_ = std::min(intercept_, pointY_[i] - slope_ * pointX_[i]);
+}
+
+void EMGClockSync::publish(double senderTime, double hostTime, double arrivalTime)
+{
+	const uint64_t version = version_.load(std::memory_order_relaxed);
+	version_.store(version + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	offset_.store(hostTime - senderTime, std::memory_order_relaxed);
+	drift_.store(slope_ - 1.0, std::memory_order_relaxed);
+	delay_.store(arrivalTime - hostTime, std::memory_order_relaxed);
+	publishedSamples_.store(samples_, std::memory_order_relaxed);
+	publishedResets_.store(resets_, std::memory_order_relaxed);
+	version_.store(version + 2, std::memory_order_release);
+}
+
+EMGClockSync::Estimate EMGClockSync::getEstimate() const
+{
+	Estimate estimate;
+	uint64_t before;
+	do
+	{
+		before = version_.load(std::memory_order_acquire);
+		estimate.offset = offset_.load(std::memory_order_relaxed);
+		estimate.drift = drift_.load(std::memory_order_relaxed);
+		estimate.delay = delay_.load(std::memory_order_relaxed);
+		estimate.samples = publishedSamples_.load(std::memory_order_relaxed);
+		estimate.resets = publishedResets_.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((before & 1) != 0 || version_.load(std::memory_order_relaxed) != before);
+	return estimate;
+}
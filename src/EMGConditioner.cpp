@@ -0,0 +1,103 @@
+#include "EMGConditioner.h"
+
+#include <algorithm>
+#include <limits>
+
+const double EMGConditioner::MAX_DC_GAIN = 0.01;
+
+EMGBiquadBank::EMGBiquadBank() : enabled_(false), nbChannel_(0),
+	b0_(1.0), b1_(0.0), b2_(0.0), a1_(0.0), a2_(0.0)
+{
+}
+
+bool EMGBiquadBank::setup(const std::vector<double>& aCoeff, const std::vector<double>& bCoeff, size_t nbChannel)
+{
+	nbChannel_ = nbChannel;
+	enabled_ = !bCoeff.empty();
+	if (aCoeff.size() > 2 || bCoeff.size() > 3)
+	{
+		enabled_ = false;
+		return false;
+	}
+
+	a1_ = aCoeff.size() > 0 ? aCoeff[0] : 0.0;
+	a2_ = aCoeff.size() > 1 ? aCoeff[1] : 0.0;
+	// Like aCoeff, a short bCoeff leaves out the leading 1: "b1 b2" is 1 b1 b2
+	const size_t first = bCoeff.size() == 3 ? 1 : 0;
+	b0_ = first ? bCoeff[0] : 1.0;
+	b1_ = bCoeff.size() > first ? bCoeff[first] : 0.0;
+	b2_ = bCoeff.size() > first + 1 ? bCoeff[first + 1] : 0.0;
+
+	s1_.assign(nbChannel_, 0.0);
+	s2_.assign(nbChannel_, 0.0);
+	return true;
+}
+
+void EMGBiquadBank::process(double* data)
+{
+	if (!enabled_)
+		return;
+
+	// Coefficients in locals and no aliasing between data and the state: the loop is vectorized over channels
+	const double b0 = b0_, b1 = b1_, b2 = b2_, a1 = a1_, a2 = a2_;
+	double* __restrict s1 = s1_.data();
+	double* __restrict s2 = s2_.data();
+	double* __restrict x = data;
+	for (size_t i = 0; i < nbChannel_; ++i)
+	{
+		const double in = x[i];
+		const double out = b0 * in + s1[i];
+		s1[i] = b1 * in - a1 * out + s2[i];
+		s2[i] = b2 * in - a2 * out;
+		x[i] = out;
+	}
+}
+
+double EMGBiquadBank::getDCGain() const
+{
+	const double numerator = b0_ + b1_ + b2_;
+	const double denominator = 1.0 + a1_ + a2_;
+	if (denominator == 0.0)
+		return numerator == 0.0 ? 0.0 : std::numeric_limits<double>::infinity();
+	return numerator / denominator;
+}
+
+void EMGBiquadBank::reset()
+{
+	std::fill(s1_.begin(), s1_.end(), 0.0);
+	std::fill(s2_.begin(), s2_.end(), 0.0);
+}
+
+EMGConditioner::EMGConditioner() : nbChannel_(0)
+{
+}
+
+bool EMGConditioner::setup(const std::vector<double>& dcA, const std::vector<double>& dcB,
+	const std::vector<double>& hpA, const std::vector<double>& hpB,
+	const std::vector<double>& lpA, const std::vector<double>& lpB, size_t nbChannel)
+{
+	nbChannel_ = nbChannel;
+	bool ok = dcFilter_.setup(dcA, dcB, nbChannel);
+	ok &= hpFilter_.setup(hpA, hpB, nbChannel);
+	ok &= lpFilter_.setup(lpA, lpB, nbChannel);
+	return ok;
+}
+
+void EMGConditioner::process(double* data)
+{
+	dcFilter_.process(data);
+	hpFilter_.process(data);
+
+	// Full-wave rectification
+	for (size_t i = 0; i < nbChannel_; ++i)
+		data[i] = data[i] < 0.0 ? -data[i] : data[i];
+
+	lpFilter_.process(data);
+}
+
+void EMGConditioner::reset()
+{
+	dcFilter_.reset();
+	hpFilter_.reset();
+	lpFilter_.reset();
+}
@@ -0,0 +1,276 @@
+#include "EMGFanIn.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// Sender time step back taken as a restart of the sender clock, as in EMGClockSync
+	const double RESTART_TIME = 1.0;
+}
+
+EMGFanIn::EMGFanIn() : nbChannel_(0), alignment_(SEQUENCE), tolerance_(0.0), policy_(HOLD), timeout_(0.0), fullMask_(0),
+	orderHead_(0), nbPending_(0), nbFree_(0), nbComplete_(0), firstArrivalBound_(0.0), hasPublished_(false), lastKey_(0.0), readyHead_(0), readyCount_(0),
+	frameCounter_(0), counters_()
+{
+}
+
+void EMGFanIn::setup(const std::vector<std::vector<size_t>>& channels, size_t nbChannel, Alignment alignment,
+	double tolerance, StallPolicy policy, double timeout, size_t window)
+{
+	channels_ = channels;
+	nbChannel_ = nbChannel;
+	alignment_ = alignment;
+	tolerance_ = tolerance;
+	policy_ = policy;
+	timeout_ = timeout;
+	fullMask_ = channels_.size() >= 32 ? 0xFFFFFFFFu : (uint32_t(1) << channels_.size()) - 1;
+
+	window = std::max<size_t>(window, 2);
+	Slot empty = { false, 0.0, 0, 0.0, 0.0 };
+	slots_.assign(window, empty);
+	values_.assign(window * nbChannel_, 0.0);
+	order_.assign(window, 0);
+	orderHead_ = 0;
+	nbPending_ = 0;
+	free_.resize(window);
+	for (size_t i = 0; i < window; ++i)
+		free_[i] = window - 1 - i;
+	nbFree_ = window;
+	nbComplete_ = 0;
+	firstArrivalBound_ = 0.0;
+	lastValues_.assign(nbChannel_, 0.0);
+	sourceKey_.assign(channels_.size(), -std::numeric_limits<double>::infinity());
+	hasPublished_ = false;
+	lastKey_ = 0.0;
+
+	ready_.assign(window * nbChannel_, 0.0);
+	readyTime_.assign(window, 0.0);
+	readySequence_.assign(window, 0);
+	readyHead_ = 0;
+	readyCount_ = 0;
+	frameCounter_ = 0;
+	counters_ = Counters();
+}
+
+void EMGFanIn::add(size_t source, const double* values, uint64_t sequence, double senderTime, double now)
+{
+	const uint32_t bit = uint32_t(1) << source;
+	const double key = alignment_ == SEQUENCE ? static_cast<double>(sequence) : senderTime;
+
+	// A step back larger than any reordering: the sender restarted its numbering or its clock
+	const double restartStep = alignment_ == SEQUENCE ? static_cast<double>(slots_.size()) : RESTART_TIME;
+	if (key < sourceKey_[source] - restartStep)
+	{
+		restart(key + restartStep);
+		sourceKey_[source] = key;
+	}
+	else
+		sourceKey_[source] = std::max(sourceKey_[source], key);
+
+	// Too late for its frame, already published or dropped
+	if (hasPublished_ && (alignment_ == SEQUENCE ? key <= lastKey_ : key <= lastKey_ + tolerance_))
+	{
+		counters_.late++;
+		return;
+	}
+
+	// Binary search in the pending frames: the frame of the sample, or the position of a new one in key order
+	int index = -1;
+	const size_t position = search(key, true);
+	if (alignment_ == SEQUENCE)
+	{
+		if (position > 0 && slots_[pending(position - 1)].key == key)
+			index = static_cast<int>(pending(position - 1));
+	}
+	else
+	{
+		// The oldest frame within the tolerance that misses this source
+		for (size_t i = search(key - tolerance_, false); i < nbPending_ && index < 0; ++i)
+		{
+			const Slot& slot = slots_[pending(i)];
+			if (slot.key > key + tolerance_)
+				break;
+			if (!(slot.mask & bit))
+				index = static_cast<int>(pending(i));
+		}
+	}
+	if (index >= 0 && (slots_[index].mask & bit))
+	{
+		counters_.late++; // Duplicate sequence number
+		return;
+	}
+
+	if (index < 0)
+	{
+		// New frame, the window is full when the sources drift apart or one of them stalls
+		size_t insert = position;
+		if (nbFree_ == 0)
+		{
+			resolveOldest();
+			if (insert == 0)
+			{
+				// Older than the frame just published
+				counters_.late++;
+				return;
+			}
+			insert--;
+		}
+		if (nbPending_ == 0)
+			firstArrivalBound_ = now;
+		index = static_cast<int>(free_[--nbFree_]);
+		// Usually appended, the frames after a reordered sample move by one
+		for (size_t i = nbPending_; i > insert; --i)
+			order_[(orderHead_ + i) % order_.size()] = pending(i - 1);
+		order_[(orderHead_ + insert) % order_.size()] = index;
+		nbPending_++;
+
+		Slot& slot = slots_[index];
+		slot.used = true;
+		slot.key = key;
+		slot.mask = 0;
+		slot.firstArrival = now;
+		// Channels of no source keep their value
+		std::copy(lastValues_.begin(), lastValues_.end(), values_.begin() + index * nbChannel_);
+	}
+
+	Slot& slot = slots_[index];
+	double* row = &values_[index * nbChannel_];
+	const std::vector<size_t>& channels = channels_[source];
+	for (size_t i = 0; i < channels.size(); ++i)
+		row[channels[i]] = values[i];
+	slot.mask |= bit;
+	slot.lastArrival = now;
+	if (slot.mask == fullMask_)
+		nbComplete_++;
+
+	// Publish in key order: complete frames, and the older incomplete ones a newer complete frame has overtaken
+	while (nbComplete_ > 0)
+		resolveOldest();
+	expire(now);
+}
+
+size_t EMGFanIn::search(double key, bool after) const
+{
+	size_t low = 0, high = nbPending_;
+	while (low < high)
+	{
+		const size_t middle = (low + high) / 2;
+		const double pendingKey = slots_[pending(middle)].key;
+		if (pendingKey < key || (after && pendingKey == key))
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+void EMGFanIn::expire(double now)
+{
+	// Nothing can have timed out before the earliest first arrival
+	if (nbPending_ == 0 || now - firstArrivalBound_ < timeout_)
+		return;
+
+	// Resolved in key order, up to the last frame that timed out
+	size_t count = 0;
+	double earliest = now;
+	for (size_t i = 0; i < nbPending_; ++i)
+	{
+		const double firstArrival = slots_[pending(i)].firstArrival;
+		if (now - firstArrival >= timeout_)
+			count = i + 1;
+		else
+			earliest = std::min(earliest, firstArrival);
+	}
+	firstArrivalBound_ = earliest;
+	while (count-- > 0)
+		resolveOldest();
+}
+
+void EMGFanIn::restart(double oldKeys)
+{
+	// The frames of the former numbering go out first, those of the new one stay pending
+	const size_t first = search(oldKeys, true);
+	for (size_t i = first; i < nbPending_; ++i)
+	{
+		const size_t index = pending(i);
+		free_[nbFree_++] = index;
+		publish(index);
+	}
+	nbPending_ = first;
+	hasPublished_ = false;
+	counters_.restarts++;
+}
+
+void EMGFanIn::resolveOldest()
+{
+	if (nbPending_ == 0)
+		return;
+	const size_t index = pending(0);
+	orderHead_ = (orderHead_ + 1) % order_.size();
+	nbPending_--;
+	free_[nbFree_++] = index;
+	publish(index);
+}
+
+void EMGFanIn::publish(size_t index)
+{
+	Slot& slot = slots_[index];
+	double* row = &values_[index * nbChannel_];
+	const bool complete = slot.mask == fullMask_;
+	slot.used = false;
+	hasPublished_ = true;
+	lastKey_ = slot.key;
+
+	if (complete)
+		nbComplete_--;
+	else
+	{
+		if (policy_ == DROP)
+		{
+			counters_.dropped++;
+			return;
+		}
+		for (size_t source = 0; source < channels_.size(); ++source)
+		{
+			if (slot.mask & (uint32_t(1) << source))
+				continue;
+			for (size_t channel : channels_[source])
+				row[channel] = policy_ == HOLD ? lastValues_[channel] : 0.0;
+		}
+		counters_.incomplete++;
+	}
+	std::copy(row, row + nbChannel_, lastValues_.begin());
+
+	// The output is read after every add(), a full queue only happens if pop() is never called
+	if (readyCount_ == readyTime_.size())
+	{
+		readyHead_ = (readyHead_ + 1) % readyTime_.size();
+		readyCount_--;
+	}
+	const size_t tail = (readyHead_ + readyCount_) % readyTime_.size();
+	std::copy(row, row + nbChannel_, ready_.begin() + tail * nbChannel_);
+	readyTime_[tail] = slot.lastArrival;
+	readySequence_[tail] = alignment_ == SEQUENCE ? static_cast<uint64_t>(slot.key) : frameCounter_;
+	frameCounter_++;
+	readyCount_++;
+	counters_.frames++;
+}
+
+bool EMGFanIn::pop(double* frame, double& time, uint64_t& sequence)
+{
+	if (readyCount_ == 0)
+		return false;
+	std::copy(ready_.begin() + readyHead_ * nbChannel_, ready_.begin() + (readyHead_ + 1) * nbChannel_, frame);
+	time = readyTime_[readyHead_];
+	sequence = readySequence_[readyHead_];
+	readyHead_ = (readyHead_ + 1) % readyTime_.size();
+	readyCount_--;
+	return true;
+}
+
+double EMGFanIn::nextDeadline() const
+{
+	return nbPending_ > 0 ? firstArrivalBound_ + timeout_ : -1.0;
+}
@@ -0,0 +1,126 @@
+#include "EMGFrameAssembler.h"
+
+#include <algorithm>
+
+namespace
+{
+	// A frame this many times maxPending behind the newest one comes from a restarted sender
+	const size_t RESTART_FACTOR = 64;
+}
+
+EMGFrameAssembler::EMGFrameAssembler() : nbChannel_(0), timeout_(0.0), started_(false), lastSequence_(0), counters_()
+{
+}
+
+void EMGFrameAssembler::setup(size_t nbChannel, size_t maxPending, double timeout)
+{
+	nbChannel_ = nbChannel;
+	timeout_ = timeout;
+	maxPending = std::max<size_t>(maxPending, 1);
+	Slot empty = { false, 0, 0, 0, 0.0 };
+	slots_.assign(maxPending, empty);
+	frames_.assign(maxPending * nbChannel_, 0.0);
+	started_ = false;
+	lastSequence_ = 0;
+	counters_ = Counters();
+}
+
+bool EMGFrameAssembler::add(const EMGPacketHeader& header, const char* buffer, size_t size, double now, double* frame)
+{
+	// Headers checked before the fragment touches the frames in progress
+	EMGPacketHeader fragmentPacket;
+	EMGFragmentHeader fragment;
+	if (EMGBinaryPacket::decodeFragmentHeader(buffer, size, fragmentPacket, fragment) != EMGBinaryPacket::OK)
+	{
+		counters_.invalid++;
+		return false;
+	}
+
+	Slot& slot = slots_[header.sequence % slots_.size()];
+	double* slotFrame = &frames_[(header.sequence % slots_.size()) * nbChannel_];
+
+	// Wrap-around distance to the newest frame: frames older than the pending window are late
+	const int32_t age = static_cast<int32_t>(lastSequence_ - header.sequence);
+	if (started_ && age >= static_cast<int32_t>(slots_.size()))
+	{
+		if (age < static_cast<int32_t>(RESTART_FACTOR * slots_.size()))
+		{
+			counters_.late++;
+			return false;
+		}
+		// The sender numbers its frames from the start again
+		restart();
+	}
+	if (!slot.active || slot.sequence != header.sequence)
+	{
+		if (slot.sequence == header.sequence && started_ && age >= 0)
+		{
+			// Frame already completed or dropped
+			counters_.late++;
+			return false;
+		}
+		if (slot.active)
+			counters_.incomplete++;
+		slot.active = true;
+		slot.sequence = header.sequence;
+		slot.received = 0;
+		slot.expected = 0;
+		slot.start = now;
+		std::fill(slotFrame, slotFrame + nbChannel_, 0.0);
+		if (!started_ || age < 0)
+			lastSequence_ = header.sequence;
+		started_ = true;
+	}
+
+	const uint64_t expected = fragment.count == 64 ? ~uint64_t(0) : (uint64_t(1) << fragment.count) - 1;
+	const uint64_t bit = uint64_t(1) << fragment.index;
+	if ((slot.expected != 0 && slot.expected != expected) || (slot.received & bit))
+	{
+		counters_.late++;
+		return false;
+	}
+	EMGBinaryPacket::decodeFragmentSamples(buffer, fragmentPacket, fragment, slotFrame, nbChannel_);
+	slot.expected = expected;
+	slot.received |= bit;
+	counters_.fragments++;
+	if (slot.received != slot.expected)
+		return false;
+
+	slot.active = false;
+	counters_.frames++;
+	std::copy(slotFrame, slotFrame + nbChannel_, frame);
+	return true;
+}
+
+void EMGFrameAssembler::restart()
+{
+	for (Slot& slot : slots_)
+	{
+		if (slot.active)
+			counters_.incomplete++;
+		slot = Slot();
+	}
+	started_ = false;
+	counters_.restarts++;
+}
+
+void EMGFrameAssembler::expire(double now)
+{
+	for (Slot& slot : slots_)
+	{
+		if (slot.active && now - slot.start >= timeout_)
+		{
+			slot.active = false;
+			counters_.incomplete++;
+		}
+	}
+}
+
+double EMGFrameAssembler::nextDeadline() const
+{
+	double deadline = -1.0;
+	for (const Slot& slot : slots_)
+		if (slot.active && (deadline < 0.0 || slot.start + timeout_ < deadline))
+			deadline = slot.start + timeout_;
+	return deadline;
+}
@@ -0,0 +1,75 @@
+#include "EMGKernels.h"
+
+namespace
+{
+	const double MIN_AMPLITUDE = 1.0e-6;
+
+	inline void updateMaxLoop(const double* __restrict data, double* __restrict maxAmp, size_t nbChannel)
+	{
+		for (size_t i = 0; i < nbChannel; ++i)
+			maxAmp[i] = data[i] > maxAmp[i] ? data[i] : maxAmp[i];
+	}
+
+	inline void normalizeLoop(double* __restrict data, const double* __restrict maxAmp, size_t nbChannel)
+	{
+		for (size_t i = 0; i < nbChannel; ++i)
+		{
+			// Both sides are computed, the division by a too small maximum is discarded by the select
+			const double scaled = data[i] / maxAmp[i];
+			const double clamped = scaled > 1.0 ? 1.0 : scaled;
+			data[i] = maxAmp[i] > MIN_AMPLITUDE ? clamped : 0.0;
+		}
+	}
+
+	template <size_t N>
+	void updateMaxFixed(const double* data, double* maxAmp, size_t)
+	{
+		updateMaxLoop(data, maxAmp, N);
+	}
+
+	template <size_t N>
+	void normalizeFixed(double* data, const double* maxAmp, size_t)
+	{
+		normalizeLoop(data, maxAmp, N);
+	}
+
+	void updateMaxGeneric(const double* data, double* maxAmp, size_t nbChannel)
+	{
+		updateMaxLoop(data, maxAmp, nbChannel);
+	}
+
+	void normalizeGeneric(double* data, const double* maxAmp, size_t nbChannel)
+	{
+		normalizeLoop(data, maxAmp, nbChannel);
+	}
+
+	template <size_t N>
+	EMGKernels::Functions fixed()
+	{
+		EMGKernels::Functions functions = { &updateMaxFixed<N>, &normalizeFixed<N>, N };
+		return functions;
+	}
+}
+
+namespace EMGKernels
+{
+	Functions select(size_t nbChannel)
+	{
+		switch (nbChannel)
+		{
+		case 8:
+			return fixed<8>();
+		case 16:
+			return fixed<16>();
+		case 32:
+			return fixed<32>();
+		case 64:
+			return fixed<64>();
+		default:
+		{
+			Functions functions = { &updateMaxGeneric, &normalizeGeneric, 0 };
+			return functions;
+		}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef EMG_LEGACY_PARSER_H_
+#define EMG_LEGACY_PARSER_H_
+
+// Text parsing of the plugin before EMGTextParser, the reference of the benchmarks and
+// of EMGTextParserTest. Not part of the plugin.
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+* @return false if the brackets are missing or inverted, the values are then all 0
+*/
+inline bool legacyParse(const char* emgUDPBuffer, std::vector<double>& tempEMGdata)
+{
+	const int NBOFCHANNEL = tempEMGdata.size();
+	std::string received_str(emgUDPBuffer);
+	size_t first_bracket = received_str.find('[');
+	size_t last_bracket = received_str.rfind(']');
+	if (first_bracket == std::string::npos || last_bracket == std::string::npos || last_bracket <= first_bracket)
+	{
+		std::fill(tempEMGdata.begin(), tempEMGdata.end(), 0.0);
+		return false;
+	}
+	std::string inner_content = received_str.substr(first_bracket + 1, last_bracket - first_bracket - 1);
+	std::replace(inner_content.begin(), inner_content.end(), '"', ' ');
+	std::replace(inner_content.begin(), inner_content.end(), ',', ' ');
+	std::istringstream iss(inner_content);
+	double value;
+	int iLoc = 0;
+	while (iss >> value && iLoc < NBOFCHANNEL)
+		tempEMGdata[iLoc++] = value;
+	while (iLoc < NBOFCHANNEL)
+		tempEMGdata[iLoc++] = 0.0;
+	return true;
+}
+
+#endif
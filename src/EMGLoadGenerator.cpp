@@ -0,0 +1,281 @@
+// Stand-alone UDP sender of synthetic EMG, to load-test the plugin on loopback.
+// Usage: EMGLoadGenerator [--ip 127.0.0.1] [--port 31000] [--rate 1000] [--channels 16] [--duration 10]
+//                         [--format text|textseq|binary|binary64] [--burstPeriod 2] [--spikeRate 0]
+//                         [--malformed 0] [--loss 0] [--reorder 0] [--seed 1] [--shm /emg_udp_simulink]
+//                         [--fragment 0]
+// Every channel is white noise modulated by an envelope alternating rest and contraction
+// bursts (burstPeriod seconds, half of it active, 0 for a constant level). spikeRate adds
+// artefacts of 20 times the contraction amplitude on a random channel, per second. malformed,
+// loss and reorder are the fractions of packets sent corrupted, not sent, or swapped with
+// the next one. rate 0 sends as fast as possible. shm writes the samples to the shared memory
+// ring of a plugin with <source>shm</source> instead of sending packets; format, malformed,
+// loss and reorder then do not apply. fragment splits each binary frame into datagrams of
+// at most this many bytes (FLAG_FRAGMENT), each one lost independently; malformed and
+// reorder do not apply to fragments.
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EMGBinaryPacket.h"
+#include "EMGShmRing.h"
+#include "EMGTextParser.h"
+
+namespace
+{
+	struct Options
+	{
+		std::string ip = "127.0.0.1";
+		int port = 31000;
+		double rate = 1000.0;
+		size_t channels = 16;
+		double duration = 10.0;
+		std::string format = "text";
+		double burstPeriod = 2.0;
+		double spikeRate = 0.0;
+		double malformed = 0.0;
+		double loss = 0.0;
+		double reorder = 0.0;
+		unsigned seed = 1;
+		std::string shm;
+		size_t fragment = 0;
+	};
+
+	bool parseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; i += 2)
+		{
+			const std::string key = argv[i];
+			if (i + 1 >= argc)
+				return false;
+			const char* value = argv[i + 1];
+			if (key == "--ip")
+				options.ip = value;
+			else if (key == "--port")
+				options.port = atoi(value);
+			else if (key == "--rate")
+				options.rate = atof(value);
+			else if (key == "--channels")
+				options.channels = static_cast<size_t>(atoi(value));
+			else if (key == "--duration")
+				options.duration = atof(value);
+			else if (key == "--format")
+				options.format = value;
+			else if (key == "--burstPeriod")
+				options.burstPeriod = atof(value);
+			else if (key == "--spikeRate")
+				options.spikeRate = atof(value);
+			else if (key == "--malformed")
+				options.malformed = atof(value);
+			else if (key == "--loss")
+				options.loss = atof(value);
+			else if (key == "--reorder")
+				options.reorder = atof(value);
+			else if (key == "--seed")
+				options.seed = static_cast<unsigned>(atoi(value));
+			else if (key == "--shm")
+				options.shm = value;
+			else if (key == "--fragment")
+				options.fragment = static_cast<size_t>(atoi(value));
+			else
+				return false;
+		}
+		return options.channels > 0 && options.rate >= 0.0 && (options.format == "text" || options.format == "textseq" ||
+			options.format == "binary" || options.format == "binary64");
+	}
+
+	/**
+	* Contraction envelope between 0.05 (rest) and 1, smooth on and off ramps.
+	*/
+	double envelope(double time, double burstPeriod)
+	{
+		if (burstPeriod <= 0.0)
+			return 1.0;
+		const double phase = std::fmod(time, burstPeriod) / burstPeriod;
+		if (phase >= 0.5)
+			return 0.05;
+		return 0.05 + 0.95 * std::sin(phase * 2.0 * M_PI) * std::sin(phase * 2.0 * M_PI);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::cout << "Usage: " << argv[0] << " [--ip 127.0.0.1] [--port 31000] [--rate 1000] [--channels 16] [--duration 10]\n"
+			<< "       [--format text|textseq|binary|binary64] [--burstPeriod 2] [--spikeRate 0]\n"
+			<< "       [--malformed 0] [--loss 0] [--reorder 0] [--seed 1] [--shm /emg_udp_simulink] [--fragment 0]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// The plugin creates the ring in init(), start it first
+	EMGShmProducer producer = {};
+	const bool shm = !options.shm.empty();
+	if (shm && emg_shm_attach(&producer, options.shm.c_str(), options.channels) != 0)
+	{
+		std::cerr << "Cannot attach to the shared memory ring " << options.shm << " of " << options.channels
+			<< " channels, is the plugin running with <source>shm</source>?" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	int sockFd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sockFd < 0)
+	{
+		std::cerr << "Failed to create UDP socket: " << strerror(errno) << std::endl;
+		return EXIT_FAILURE;
+	}
+	struct sockaddr_in destination;
+	memset(&destination, 0, sizeof(destination));
+	destination.sin_family = AF_INET;
+	destination.sin_port = htons(options.port);
+	if (inet_pton(AF_INET, options.ip.c_str(), &destination.sin_addr) <= 0)
+	{
+		std::cerr << "Invalid IP address: " << options.ip << std::endl;
+		close(sockFd);
+		return EXIT_FAILURE;
+	}
+
+	const size_t nbChannel = options.channels;
+	const bool binary = options.format == "binary" || options.format == "binary64";
+	const EMGBinaryPacket::SampleType sampleType = options.format == "binary64" ? EMGBinaryPacket::FLOAT64 : EMGBinaryPacket::FLOAT32;
+	const size_t fragmentChannels = binary && options.fragment > 0 ? EMGBinaryPacket::fragmentChannels(options.fragment, sampleType) : 0;
+	const size_t nbFragment = fragmentChannels > 0 ? (nbChannel + fragmentChannels - 1) / fragmentChannels : 0;
+	if (binary && options.fragment > 0 && (fragmentChannels == 0 || nbFragment > EMGBinaryPacket::MAX_FRAGMENTS))
+	{
+		std::cerr << "Cannot split " << nbChannel << " channels into at most " << EMGBinaryPacket::MAX_FRAGMENTS
+			<< " fragments of " << options.fragment << " bytes." << std::endl;
+		close(sockFd);
+		return EXIT_FAILURE;
+	}
+	if (shm)
+		std::cout << "Writing " << nbChannel << " channels of synthetic EMG to the shared memory ring " << options.shm
+			<< " at " << options.rate << " Hz for " << options.duration << " s" << std::endl;
+	else
+		std::cout << "Sending " << nbChannel << " channels of synthetic EMG to " << options.ip << ":" << options.port << ", "
+			<< options.format << " packets at " << options.rate << " Hz for " << options.duration << " s" << std::endl;
+
+	std::mt19937 random(options.seed);
+	std::normal_distribution<double> noise(0.0, 1.0);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::uniform_int_distribution<size_t> channel(0, nbChannel - 1);
+	const double spikeProbability = options.rate > 0.0 ? options.spikeRate / options.rate : 0.0;
+
+	std::vector<double> sample(nbChannel);
+	// Two packets, the second one holds a packet delayed by a reordering
+	std::vector<char> packet(EMGBinaryPacket::HEADER_SIZE + nbChannel * 32 + 16);
+	std::vector<char> held(packet.size());
+	size_t heldSize = 0;
+	uint64_t sent = 0, failed = 0, lost = 0, malformed = 0, reordered = 0, spikes = 0;
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const std::chrono::duration<double> period(options.rate > 0.0 ? 1.0 / options.rate : 0.0);
+	const uint64_t nbSample = options.rate > 0.0 ? static_cast<uint64_t>(options.duration * options.rate) : 0;
+	for (uint64_t i = 0; options.rate > 0.0 ? i < nbSample : std::chrono::steady_clock::now() - start < std::chrono::duration<double>(options.duration); ++i)
+	{
+		if (options.rate > 0.0)
+			std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period * static_cast<double>(i)));
+		const double time = options.rate > 0.0 ? i / options.rate : std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const double level = envelope(time, options.burstPeriod);
+		for (size_t c = 0; c < nbChannel; ++c)
+			sample[c] = level * noise(random);
+		if (uniform(random) < spikeProbability)
+		{
+			sample[channel(random)] = 20.0 * (uniform(random) < 0.5 ? -1.0 : 1.0);
+			spikes++;
+		}
+
+		const uint32_t sequence = static_cast<uint32_t>(i);
+		if (shm)
+		{
+			emg_shm_write(&producer, sample.data(), sequence, time);
+			sent++;
+			continue;
+		}
+		if (nbFragment > 0)
+		{
+			// One datagram per fragment, each one lost independently
+			for (size_t index = 0; index < nbFragment; ++index)
+			{
+				const size_t first = index * fragmentChannels;
+				const size_t size = EMGBinaryPacket::encodeFragment(packet.data(), packet.size(), sample.data(), first,
+					std::min(fragmentChannels, nbChannel - first), nbChannel, index, nbFragment, sequence, time, sampleType);
+				if (uniform(random) < options.loss)
+					lost++;
+				else if (size > 0 && sendto(sockFd, packet.data(), size, 0, (const struct sockaddr*)&destination, sizeof(destination)) == static_cast<ssize_t>(size))
+					sent++;
+				else
+					failed++;
+			}
+			continue;
+		}
+		size_t size = binary ?
+			EMGBinaryPacket::encode(packet.data(), packet.size(), sample.data(), nbChannel, sequence, time, sampleType) :
+			EMGTextParser::format(packet.data(), packet.size(), sample.data(), nbChannel, options.format == "textseq" ? sequence : -1);
+		if (size == 0)
+		{
+			failed++;
+			continue;
+		}
+
+		if (uniform(random) < options.loss)
+		{
+			lost++;
+			continue;
+		}
+		if (uniform(random) < options.malformed)
+		{
+			// Truncated binary header, or text without its opening bracket
+			if (binary)
+				size = EMGBinaryPacket::HEADER_SIZE / 2;
+			else
+				*static_cast<char*>(std::memchr(packet.data(), '[', size)) = ' ';
+			malformed++;
+		}
+		if (heldSize == 0 && uniform(random) < options.reorder)
+		{
+			// Sent after the next packet
+			std::memcpy(held.data(), packet.data(), size);
+			heldSize = size;
+			reordered++;
+			continue;
+		}
+
+		if (sendto(sockFd, packet.data(), size, 0, (const struct sockaddr*)&destination, sizeof(destination)) == static_cast<ssize_t>(size))
+			sent++;
+		else
+			failed++;
+		if (heldSize > 0)
+		{
+			if (sendto(sockFd, held.data(), heldSize, 0, (const struct sockaddr*)&destination, sizeof(destination)) == static_cast<ssize_t>(heldSize))
+				sent++;
+			else
+				failed++;
+			heldSize = 0;
+		}
+	}
+	if (heldSize > 0 && sendto(sockFd, held.data(), heldSize, 0, (const struct sockaddr*)&destination, sizeof(destination)) == static_cast<ssize_t>(heldSize))
+		sent++;
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Sent " << sent << (shm ? " samples in " : " packets in ") << elapsed << " s (" << (elapsed > 0.0 ? sent / elapsed : 0.0) << " packets/s): "
+		<< lost << " skipped as lost, " << reordered << " reordered, " << malformed << " malformed, " << spikes << " spikes, "
+		<< failed << " failed" << std::endl;
+	close(sockFd);
+	if (shm)
+		emg_shm_detach(&producer);
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,240 @@
+#include "EMGMetrics.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	uint64_t toNs(double seconds)
+	{
+		return seconds > 0.0 ? static_cast<uint64_t>(seconds * 1.0e9) : 0;
+	}
+
+	void writeSummary(std::ostream& out, const EMGHistogram::Summary& summary)
+	{
+		out << "\t" << summary.p50 * 1.0e-3 << "\t" << summary.p99 * 1.0e-3 << "\t" << summary.max * 1.0e-3;
+	}
+}
+
+EMGHistogram::EMGHistogram() : count_(0), sum_(0), max_(0)
+{
+	for (std::atomic<uint64_t>& bucket : buckets_)
+		bucket.store(0, std::memory_order_relaxed);
+}
+
+size_t EMGHistogram::bucketIndex(uint64_t value)
+{
+	if (value < SUB_COUNT)
+		return static_cast<size_t>(value);
+	// Power of two of the value, then its SUB_BITS bits after the leading one
+	const int exponent = 63 - __builtin_clzll(value);
+	const size_t sub = static_cast<size_t>(value >> (exponent - SUB_BITS)) & (SUB_COUNT - 1);
+	return (exponent - SUB_BITS + 1) * SUB_COUNT + sub;
+}
+
+uint64_t EMGHistogram::bucketUpperBound(size_t index)
+{
+	if (index < SUB_COUNT)
+		return index;
+	const int exponent = static_cast<int>(index / SUB_COUNT) + SUB_BITS - 1;
+	const uint64_t sub = index % SUB_COUNT;
+	const uint64_t lower = (SUB_COUNT + sub) << (exponent - SUB_BITS);
+	return lower + ((uint64_t(1) << (exponent - SUB_BITS)) - 1);
+}
+
+void EMGHistogram::record(uint64_t value)
+{
+	std::atomic<uint64_t>& bucket = buckets_[bucketIndex(value)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	if (value > max_.load(std::memory_order_relaxed))
+		max_.store(value, std::memory_order_relaxed);
+	count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint64_t EMGHistogram::percentile(double fraction) const
+{
+	const uint64_t count = count_.load(std::memory_order_acquire);
+	if (count == 0)
+		return 0;
+	const uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * count));
+	uint64_t seen = 0;
+	for (size_t i = 0; i < NB_BUCKETS; ++i)
+	{
+		seen += buckets_[i].load(std::memory_order_relaxed);
+		if (seen >= rank && seen > 0)
+		{
+			const uint64_t max = max_.load(std::memory_order_relaxed);
+			const uint64_t bound = bucketUpperBound(i);
+			return bound < max ? bound : max;
+		}
+	}
+	return max_.load(std::memory_order_relaxed);
+}
+
+EMGHistogram::Summary EMGHistogram::summarize() const
+{
+	Summary summary;
+	summary.count = count_.load(std::memory_order_acquire);
+	summary.mean = summary.count > 0 ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / summary.count : 0.0;
+	summary.p50 = percentile(0.5);
+	summary.p90 = percentile(0.9);
+	summary.p99 = percentile(0.99);
+	summary.p999 = percentile(0.999);
+	summary.max = max_.load(std::memory_order_relaxed);
+	return summary;
+}
+
+EMGMetrics::EMGMetrics() : received_(0), parsed_(0), malformed_(0), sequenceGaps_(0), reordered_(0), sequenceRestarts_(0), lost_(0), filled_(0),
+	late_(0), jitter_(0.0), hasSequence_(false), lastSequence_(0), hasArrival_(false), lastArrival_(0.0), lastSenderTime_(0.0), meanInterval_(0.0),
+	pullReady_(0), pullWoken_(0), deadlineMisses_(0)
+{
+}
+
+uint64_t EMGMetrics::now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void EMGMetrics::packetReceived(double arrivalTime, double senderTime)
+{
+	increment(received_);
+	if (hasArrival_)
+	{
+		const double interval = arrivalTime - lastArrival_;
+		interArrival_.record(toNs(interval));
+
+		// RFC 3550: J += (|D| - J) / 16, D is the change of transit time, or the deviation
+		// from the mean interval when the sender does not time stamp its packets
+		double expected;
+		if (senderTime >= 0.0 && lastSenderTime_ >= 0.0)
+		{
+			expected = senderTime - lastSenderTime_;
+		}
+		else
+		{
+			meanInterval_ = meanInterval_ > 0.0 ? meanInterval_ + (interval - meanInterval_) / 16.0 : interval;
+			expected = meanInterval_;
+		}
+		const double jitter = jitter_.load(std::memory_order_relaxed);
+		jitter_.store(jitter + (std::fabs(interval - expected) - jitter) / 16.0, std::memory_order_relaxed);
+	}
+	hasArrival_ = true;
+	lastArrival_ = arrivalTime;
+	lastSenderTime_ = senderTime;
+}
+
+void EMGMetrics::packetDecoded(bool ok, uint64_t parseTimeNs)
+{
+	if (ok)
+		increment(parsed_);
+	else
+		increment(malformed_);
+	parseTime_.record(parseTimeNs);
+}
+
+void EMGMetrics::sequence(uint32_t sequence)
+{
+	if (hasSequence_)
+	{
+		// Modulo 2^32: a small forward step is a gap, a small backward step a late packet and
+		// a larger one a sender numbering from 0 again
+		const uint32_t step = sequence - lastSequence_;
+		if (step > 0x80000000u && lastSequence_ - sequence > RESTART_WINDOW)
+			increment(sequenceRestarts_);
+		else if (step == 0 || step > 0x80000000u)
+		{
+			increment(reordered_);
+			return;
+		}
+		else if (step > 1)
+			sequenceGaps_.store(sequenceGaps_.load(std::memory_order_relaxed) + step - 1, std::memory_order_relaxed);
+	}
+	hasSequence_ = true;
+	lastSequence_ = sequence;
+}
+
+void EMGMetrics::reorderCounters(uint64_t lost, uint64_t filled, uint64_t late)
+{
+	lost_.store(lost, std::memory_order_relaxed);
+	filled_.store(filled, std::memory_order_relaxed);
+	late_.store(late, std::memory_order_relaxed);
+}
+
+void EMGMetrics::published(double latency)
+{
+	receiveLatency_.record(toNs(latency));
+}
+
+void EMGMetrics::consumed(double age)
+{
+	sampleAge_.record(toNs(age));
+}
+
+void EMGMetrics::pulled(EMGSampleRing::WaitResult result, uint64_t waitNs)
+{
+	if (result == EMGSampleRing::READY)
+	{
+		increment(pullReady_);
+		return;
+	}
+	increment(result == EMGSampleRing::WOKEN ? pullWoken_ : deadlineMisses_);
+	pullWait_.record(waitNs);
+}
+
+EMGMetrics::Snapshot EMGMetrics::snapshot(const EMGSampleRing::Counters& ring) const
+{
+	Snapshot snapshot;
+	readCounters(snapshot, ring);
+	snapshot.parseTime = parseTime_.summarize();
+	snapshot.receiveLatency = receiveLatency_.summarize();
+	snapshot.sampleAge = sampleAge_.summarize();
+	snapshot.interArrival = interArrival_.summarize();
+	snapshot.pullWait = pullWait_.summarize();
+	return snapshot;
+}
+
+void EMGMetrics::readCounters(Snapshot& snapshot, const EMGSampleRing::Counters& ring) const
+{
+	snapshot.received = received_.load(std::memory_order_relaxed);
+	snapshot.parsed = parsed_.load(std::memory_order_relaxed);
+	snapshot.malformed = malformed_.load(std::memory_order_relaxed);
+	snapshot.overruns = ring.overruns;
+	snapshot.dropped = ring.dropped;
+	snapshot.sequenceGaps = sequenceGaps_.load(std::memory_order_relaxed);
+	snapshot.reordered = reordered_.load(std::memory_order_relaxed);
+	snapshot.sequenceRestarts = sequenceRestarts_.load(std::memory_order_relaxed);
+	snapshot.lost = lost_.load(std::memory_order_relaxed);
+	snapshot.filled = filled_.load(std::memory_order_relaxed);
+	snapshot.late = late_.load(std::memory_order_relaxed);
+	snapshot.jitter = jitter_.load(std::memory_order_relaxed);
+	snapshot.pullReady = pullReady_.load(std::memory_order_relaxed);
+	snapshot.pullWoken = pullWoken_.load(std::memory_order_relaxed);
+	snapshot.deadlineMisses = deadlineMisses_.load(std::memory_order_relaxed);
+}
+
+void EMGMetrics::writeHeader(std::ostream& out)
+{
+	out << "time\treceived\tparsed\tmalformed\toverruns\tdropped\tsequenceGaps\treordered\tsequenceRestarts\tlost\tfilled\tlate\tjitter_us";
+	const char* histograms[] = { "parse", "latency", "age", "interArrival" };
+	for (const char* name : histograms)
+		out << "\t" << name << "_p50_us\t" << name << "_p99_us\t" << name << "_max_us";
+	out << "\tpullReady\tpullWoken\tdeadlineMisses\tpullWait_p50_us\tpullWait_p99_us\tpullWait_max_us";
+	out << std::endl;
+}
+
+void EMGMetrics::writeRow(std::ostream& out, double time, const Snapshot& snapshot)
+{
+	out << time << "\t" << snapshot.received << "\t" << snapshot.parsed << "\t" << snapshot.malformed
+		<< "\t" << snapshot.overruns << "\t" << snapshot.dropped << "\t" << snapshot.sequenceGaps
+		<< "\t" << snapshot.reordered << "\t" << snapshot.sequenceRestarts << "\t" << snapshot.lost << "\t" << snapshot.filled << "\t" << snapshot.late
+		<< "\t" << snapshot.jitter * 1.0e6;
+	writeSummary(out, snapshot.parseTime);
+	writeSummary(out, snapshot.receiveLatency);
+	writeSummary(out, snapshot.sampleAge);
+	writeSummary(out, snapshot.interArrival);
+	out << "\t" << snapshot.pullReady << "\t" << snapshot.pullWoken << "\t" << snapshot.deadlineMisses;
+	writeSummary(out, snapshot.pullWait);
+	out << std::endl;
+}
@@ -0,0 +1,247 @@
+#include "EMGMixer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	// Below this fraction of non-zero weights the sparse product is faster than the vectorized dense one
+	const double SPARSE_DENSITY = 0.35;
+}
+
+EMGMixer::EMGMixer() : enabled_(false), sparse_(false), nbInput_(0), nbOutput_(0)
+{
+}
+
+void EMGMixer::setup(size_t nbInput, size_t nbOutput)
+{
+	enabled_ = false;
+	sparse_ = false;
+	nbInput_ = nbInput;
+	nbOutput_ = nbOutput;
+	weights_.assign(nbInput_ * nbOutput_, 0.0);
+	blocked_.clear();
+	rowStart_.clear();
+	columns_.clear();
+	values_.clear();
+}
+
+bool EMGMixer::setRow(size_t output, const std::string& weights, std::string& error)
+{
+	if (output >= nbOutput_)
+	{
+		error = "output channel out of range";
+		return false;
+	}
+	double* row = &weights_[output * nbInput_];
+	std::fill(row, row + nbInput_, 0.0);
+
+	std::istringstream iss(weights);
+	std::string token;
+	size_t column = 0;
+	bool dense = false, sparse = false;
+	while (iss >> token)
+	{
+		const size_t colon = token.find(':');
+		std::istringstream value(colon == std::string::npos ? token : token.substr(colon + 1));
+		double weight;
+		if (!(value >> weight) || !value.eof())
+		{
+			error = "invalid weight '" + token + "'";
+			return false;
+		}
+		if (colon == std::string::npos)
+		{
+			dense = true;
+			if (column >= nbInput_)
+			{
+				error = "more than " + std::to_string(nbInput_) + " weights";
+				return false;
+			}
+			row[column++] = weight;
+		}
+		else
+		{
+			sparse = true;
+			std::istringstream index(token.substr(0, colon));
+			size_t input;
+			if (!(index >> input) || !index.eof() || input >= nbInput_)
+			{
+				error = "invalid input index in '" + token + "', 0 to " + std::to_string(nbInput_ - 1);
+				return false;
+			}
+			row[input] += weight;
+		}
+	}
+	if (dense && sparse)
+	{
+		error = "weights and input:weight pairs mixed";
+		return false;
+	}
+	if (dense && column != nbInput_)
+	{
+		error = std::to_string(column) + " weights instead of " + std::to_string(nbInput_);
+		return false;
+	}
+	return true;
+}
+
+bool EMGMixer::load(const std::string& fileName, const std::vector<std::string>& outputs, std::string& error)
+{
+	std::ifstream file(fileName.c_str());
+	if (!file)
+	{
+		error = "cannot open " + fileName;
+		return false;
+	}
+	std::string line;
+	size_t lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		std::istringstream iss(line);
+		std::string channel;
+		if (!(iss >> channel) || channel[0] == '#')
+			continue;
+		const size_t output = std::find(outputs.begin(), outputs.end(), channel) - outputs.begin();
+		if (output == outputs.size())
+		{
+			error = fileName + ":" + std::to_string(lineNumber) + ": channel " + channel + " is not in the subject XML";
+			return false;
+		}
+		std::string weights;
+		std::getline(iss, weights);
+		if (!setRow(output, weights, error))
+		{
+			error = fileName + ":" + std::to_string(lineNumber) + ": " + error;
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t EMGMixer::getNonZeros() const
+{
+	return static_cast<size_t>(std::count_if(weights_.begin(), weights_.end(), [](double weight) { return weight != 0.0; }));
+}
+
+size_t EMGMixer::getRowNonZeros(size_t output) const
+{
+	const std::vector<double>::const_iterator row = weights_.begin() + output * nbInput_;
+	return static_cast<size_t>(std::count_if(row, row + nbInput_, [](double weight) { return weight != 0.0; }));
+}
+
+void EMGMixer::prepare()
+{
+	const size_t nonZeros = getNonZeros();
+	sparse_ = nonZeros < SPARSE_DENSITY * weights_.size();
+	if (sparse_)
+	{
+		rowStart_.assign(1, 0);
+		columns_.clear();
+		values_.clear();
+		for (size_t row = 0; row < nbOutput_; ++row)
+		{
+			for (size_t column = 0; column < nbInput_; ++column)
+			{
+				const double weight = weights_[row * nbInput_ + column];
+				if (weight != 0.0)
+				{
+					columns_.push_back(column);
+					values_.push_back(weight);
+				}
+			}
+			rowStart_.push_back(columns_.size());
+		}
+	}
+	else
+	{
+		// Rows padded with zeros to a multiple of BLOCK
+		const size_t nbBlock = (nbOutput_ + BLOCK - 1) / BLOCK;
+		blocked_.assign(nbBlock * nbInput_ * BLOCK, 0.0);
+		for (size_t row = 0; row < nbOutput_; ++row)
+			for (size_t column = 0; column < nbInput_; ++column)
+				blocked_[((row / BLOCK) * nbInput_ + column) * BLOCK + row % BLOCK] = weights_[row * nbInput_ + column];
+	}
+	enabled_ = true;
+}
+
+void EMGMixer::process(const double* in, double* out) const
+{
+	if (sparse_)
+		processSparse(in, out);
+	else if (isFinite(in))
+		processDense(in, out);
+	else
+		processRows(in, out);
+}
+
+bool EMGMixer::isFinite(const double* in) const
+{
+	// x - x is 0 for finite values, NaN for NaN and infinities: no branch per input
+	double check = 0.0;
+	for (size_t column = 0; column < nbInput_; ++column)
+		check += in[column] - in[column];
+	return check == 0.0;
+}
+
+void EMGMixer::processDense(const double* __restrict in, double* __restrict out) const
+{
+	const double* __restrict block = blocked_.data();
+	for (size_t first = 0; first < nbOutput_; first += BLOCK)
+	{
+		// Fixed trip count: the sums stay in vector registers, two sets so that
+		// consecutive inputs do not wait for the latency of the previous addition
+		double even[BLOCK] = {};
+		double odd[BLOCK] = {};
+		size_t column = 0;
+		for (; column + 1 < nbInput_; column += 2)
+		{
+			const double value0 = in[column];
+			const double value1 = in[column + 1];
+			for (size_t i = 0; i < BLOCK; ++i)
+			{
+				even[i] += block[i] * value0;
+				odd[i] += block[BLOCK + i] * value1;
+			}
+			block += 2 * BLOCK;
+		}
+		if (column < nbInput_)
+		{
+			for (size_t i = 0; i < BLOCK; ++i)
+				even[i] += block[i] * in[column];
+			block += BLOCK;
+		}
+		const size_t count = std::min(BLOCK, nbOutput_ - first);
+		for (size_t i = 0; i < count; ++i)
+			out[first + i] = even[i] + odd[i];
+	}
+}
+
+void EMGMixer::processSparse(const double* __restrict in, double* __restrict out) const
+{
+	const size_t* __restrict columns = columns_.data();
+	const double* __restrict values = values_.data();
+	for (size_t row = 0; row < nbOutput_; ++row)
+	{
+		double sum = 0.0;
+		for (size_t k = rowStart_[row]; k < rowStart_[row + 1]; ++k)
+			sum += values[k] * in[columns[k]];
+		out[row] = sum;
+	}
+}
+
+void EMGMixer::processRows(const double* in, double* out) const
+{
+	const double* row = weights_.data();
+	for (size_t output = 0; output < nbOutput_; ++output, row += nbInput_)
+	{
+		double sum = 0.0;
+		for (size_t column = 0; column < nbInput_; ++column)
+			if (row[column] != 0.0)
+				sum += row[column] * in[column];
+		out[output] = sum;
+	}
+}
@@ -0,0 +1,177 @@
+// Loads the plugin through its create()/destroy() factory and polls it like CEINMS-RT,
+// to qualify a build with EMGLoadGenerator or the real sender.
+// Usage: EMGPluginHarness <subject.xml> <executionEMG.xml> [--plugin libEMG_UDP_Simulink.so]
+//                         [--rate 1000] [--duration 10] [--warmup 1]
+// GetDataMap() and getTime() are called through ProducersPluginVirtual every 1/rate s for
+// duration s after a warmup; the report gives the samples read, the samples skipped between
+// reads, the receive path metrics of the plugin, the read call time, the lateness of the
+// polling ticks and the heap allocations of the process (receive thread included) after the
+// warmup, which should be zero. The metrics need the EMG_UDP_Simulink class, the polling only
+// the interface.
+
+#include <dlfcn.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "EMG_UDP_Simulink.h"
+
+#include "EMGAllocationHook.h"
+
+namespace
+{
+	void printSummary(const char* name, const EMGHistogram::Summary& summary)
+	{
+		std::cout << "  " << name << ": " << summary.count << " values, p50 " << summary.p50 / 1.0e3 << " us, p99 "
+			<< summary.p99 / 1.0e3 << " us, p99.9 " << summary.p999 / 1.0e3 << " us, max " << summary.max / 1.0e3 << " us" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: " << argv[0] << " <subject.xml> <executionEMG.xml> [--plugin libEMG_UDP_Simulink.so]"
+			<< " [--rate 1000] [--duration 10] [--warmup 1]" << std::endl;
+		return EXIT_FAILURE;
+	}
+	const std::string subjectFile = argv[1];
+	const std::string executionFile = argv[2];
+	std::string pluginFile = "libEMG_UDP_Simulink.so";
+	double rate = 1000.0, duration = 10.0, warmup = 1.0;
+	for (int i = 3; i + 1 < argc; i += 2)
+	{
+		const std::string key = argv[i];
+		if (key == "--plugin")
+			pluginFile = argv[i + 1];
+		else if (key == "--rate")
+			rate = atof(argv[i + 1]);
+		else if (key == "--duration")
+			duration = atof(argv[i + 1]);
+		else if (key == "--warmup")
+			warmup = atof(argv[i + 1]);
+	}
+	if (rate <= 0.0)
+	{
+		std::cerr << "The polling rate must be positive." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	void* library = dlopen(pluginFile.c_str(), RTLD_NOW);
+	if (library == nullptr)
+	{
+		std::cerr << "Cannot load " << pluginFile << ": " << dlerror() << std::endl;
+		return EXIT_FAILURE;
+	}
+	typedef ProducersPluginVirtual* (*CreateFunction)();
+	typedef void (*DestroyFunction)(ProducersPluginVirtual*);
+	CreateFunction create = reinterpret_cast<CreateFunction>(dlsym(library, "create"));
+	DestroyFunction destroy = reinterpret_cast<DestroyFunction>(dlsym(library, "destroy"));
+	if (create == nullptr || destroy == nullptr)
+	{
+		std::cerr << pluginFile << " has no create()/destroy() factory." << std::endl;
+		dlclose(library);
+		return EXIT_FAILURE;
+	}
+
+	ProducersPluginVirtual* plugin = create();
+	// Only for the metrics, the samples are read through the interface like CEINMS-RT does
+	EMGUDPSimulink* emg = dynamic_cast<EMGUDPSimulink*>(plugin);
+	if (emg == nullptr)
+		std::cout << pluginFile << " is not the EMG_UDP_Simulink plugin, no metrics are reported." << std::endl;
+	try
+	{
+		plugin->init(subjectFile, executionFile);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "Plugin init failed: " << exception.what() << std::endl;
+		destroy(plugin);
+		dlclose(library);
+		return EXIT_FAILURE;
+	}
+
+	EMGHistogram readTime;
+	EMGHistogram lateness;
+	uint64_t ticks = 0, samples = 0;
+	double lastTime = plugin->getTime();
+	EMGMetrics::Snapshot startMetrics = {};
+
+	const std::chrono::duration<double> period(1.0 / rate);
+	const uint64_t nbWarmup = static_cast<uint64_t>(warmup * rate);
+	const uint64_t nbTick = nbWarmup + static_cast<uint64_t>(duration * rate);
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point measureStart = start;
+	for (uint64_t tick = 0; tick < nbTick; ++tick)
+	{
+		const std::chrono::steady_clock::time_point deadline =
+			start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period * static_cast<double>(tick));
+		std::this_thread::sleep_until(deadline);
+		if (tick == nbWarmup)
+		{
+			if (emg != nullptr)
+				startMetrics = emg->getMetrics();
+			measureStart = std::chrono::steady_clock::now();
+			EMGAllocationHook::counting = true;
+		}
+		const bool measured = tick >= nbWarmup;
+
+		const uint64_t callStart = EMGMetrics::now();
+		plugin->GetDataMap();
+		const double time = plugin->getTime();
+		const uint64_t callEnd = EMGMetrics::now();
+		// A new sample has a new time stamp
+		const bool fresh = time != lastTime;
+		lastTime = time;
+		if (!measured)
+			continue;
+
+		ticks++;
+		readTime.record(callEnd - callStart);
+		lateness.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - deadline).count()));
+		if (fresh)
+			samples++;
+	}
+	EMGAllocationHook::counting = false;
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - measureStart).count();
+
+	std::cout << "Polled " << ticks << " times in " << elapsed << " s: " << samples << " fresh samples ("
+		<< (elapsed > 0.0 ? samples / elapsed : 0.0) << " samples/s)" << std::endl;
+	if (emg != nullptr)
+	{
+		const EMGMetrics::Snapshot metrics = emg->getMetrics();
+		std::cout << "Samples skipped between reads: " << metrics.dropped - startMetrics.dropped << std::endl;
+		std::cout << "Plugin since init: " << metrics.received << " received, " << metrics.parsed << " parsed, " << metrics.malformed
+			<< " malformed, " << metrics.sequenceGaps << " sequence gaps, " << metrics.reordered << " reordered, " << metrics.sequenceRestarts << " sender restarts, " << metrics.lost
+			<< " lost (" << metrics.filled << " filled), " << metrics.late << " late, " << metrics.overruns << " ring overruns, "
+			<< metrics.dropped << " dropped by the read policy, jitter " << metrics.jitter * 1.0e6 << " us" << std::endl;
+		printSummary("receive to publish", metrics.receiveLatency);
+		printSummary("publish to read", metrics.sampleAge);
+		printSummary("decode", metrics.parseTime);
+		if (metrics.pullReady + metrics.pullWoken + metrics.deadlineMisses > 0)
+		{
+			std::cout << "Pull mode: " << metrics.pullReady << " reads ready, " << metrics.pullWoken << " woken, "
+				<< metrics.deadlineMisses << " deadline misses" << std::endl;
+			printSummary("pull wait", metrics.pullWait);
+		}
+	}
+	printSummary("GetDataMap and getTime", readTime.summarize());
+	printSummary("tick lateness", lateness.summarize());
+	if (emg != nullptr)
+	{
+		const EMGClockSync::Estimate clock = emg->getClockEstimate();
+		if (clock.samples > 0)
+			std::cout << "Sender clock: offset " << clock.offset << " s, drift " << clock.drift * 1.0e6 << " ppm, last delay "
+				<< clock.delay * 1.0e6 << " us, " << clock.resets << " restarts" << std::endl;
+	}
+	std::cout << "Heap allocations after the warmup: " << EMGAllocationHook::allocations.load() << std::endl;
+
+	plugin->stop();
+	destroy(plugin);
+	dlclose(library);
+	return samples > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
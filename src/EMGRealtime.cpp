@@ -0,0 +1,136 @@
+#include "EMGRealtime.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace EMGRealtime
+{
+	bool setAffinity(const std::vector<int>& cpus)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int cpu : cpus)
+			if (cpu >= 0 && cpu < CPU_SETSIZE)
+				CPU_SET(cpu, &set);
+		const int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if (error != 0)
+		{
+			std::cerr << "Warning: EMG_UDP_Simulink cannot set the CPU affinity: " << strerror(error) << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool setFifoPriority(int priority)
+	{
+		sched_param param;
+		std::memset(&param, 0, sizeof(param));
+		param.sched_priority = priority;
+		const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (error != 0)
+		{
+			std::cerr << "Warning: EMG_UDP_Simulink cannot set SCHED_FIFO priority " << priority << ": " << strerror(error) << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool lockMemory(size_t stackSize)
+	{
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+		{
+			std::cerr << "Warning: EMG_UDP_Simulink cannot lock memory: " << strerror(errno) << std::endl;
+			return false;
+		}
+		// Fault the stack pages in now rather than on the first deep call
+		volatile char* stack = static_cast<volatile char*>(alloca(stackSize));
+		for (size_t i = 0; i < stackSize; i += 4096)
+			stack[i] = 0;
+		return true;
+	}
+}
+
+EMGSocketWaiter::EMGSocketWaiter() : epollFd_(-1), stopFd_(-1)
+{
+}
+
+EMGSocketWaiter::~EMGSocketWaiter()
+{
+	close();
+}
+
+bool EMGSocketWaiter::open(int sockFd)
+{
+	close();
+	epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+	stopFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (epollFd_ < 0 || stopFd_ < 0)
+	{
+		close();
+		return false;
+	}
+
+	if (!add(stopFd_) || !add(sockFd))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool EMGSocketWaiter::add(int sockFd)
+{
+	epoll_event event;
+	std::memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = sockFd;
+	return epoll_ctl(epollFd_, EPOLL_CTL_ADD, sockFd, &event) == 0;
+}
+
+void EMGSocketWaiter::close()
+{
+	if (epollFd_ >= 0)
+		::close(epollFd_);
+	if (stopFd_ >= 0)
+		::close(stopFd_);
+	epollFd_ = -1;
+	stopFd_ = -1;
+}
+
+EMGSocketWaiter::Event EMGSocketWaiter::wait(int timeoutMs)
+{
+	epoll_event events[8];
+	int nbEvents;
+	do
+	{
+		nbEvents = epoll_wait(epollFd_, events, 8, timeoutMs);
+	} while (nbEvents < 0 && errno == EINTR);
+	if (nbEvents < 0)
+		return ERROR;
+	if (nbEvents == 0)
+		return TIMEOUT;
+
+	for (int i = 0; i < nbEvents; ++i)
+		if (events[i].data.fd == stopFd_)
+			return STOP;
+	return READABLE;
+}
+
+void EMGSocketWaiter::requestStop()
+{
+	if (stopFd_ >= 0)
+	{
+		const uint64_t one = 1;
+		if (write(stopFd_, &one, sizeof(one)) < 0)
+			std::cerr << "Warning: EMG_UDP_Simulink cannot wake up the receive thread: " << strerror(errno) << std::endl;
+	}
+}
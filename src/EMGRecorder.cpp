@@ -0,0 +1,78 @@
+#include "EMGRecorder.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+EMGRecorder::EMGRecorder(size_t capacity, size_t chunkRecords) :
+	capacity_(capacity), chunkRecords_(chunkRecords > 0 ? chunkRecords : 1), nbChannel_(0), running_(false), written_(0)
+{
+}
+
+EMGRecorder::~EMGRecorder()
+{
+	stop();
+}
+
+bool EMGRecorder::start(const std::string& fileName, const std::vector<std::string>& channelNames)
+{
+	stop();
+	if (!writer_.open(fileName, channelNames))
+		return false;
+
+	nbChannel_ = channelNames.size();
+	ring_.reset(new EMGSampleRing(capacity_, 2 * nbChannel_));
+	chunk_.resize(chunkRecords_ * writer_.getRecordSize());
+	sample_.resize(2 * nbChannel_);
+	written_ = 0;
+	running_ = true;
+	writerThread_ = std::thread(&EMGRecorder::writerLoop, this);
+	return true;
+}
+
+void EMGRecorder::stop()
+{
+	if (!running_)
+		return;
+	running_ = false;
+	if (writerThread_.joinable())
+		writerThread_.join();
+	while (drain() > 0)
+	{
+	}
+	writer_.close();
+}
+
+size_t EMGRecorder::drain()
+{
+	const size_t recordSize = writer_.getRecordSize();
+	size_t nbRecords = 0;
+	double time;
+	uint64_t sequence;
+	while (nbRecords < chunkRecords_ && ring_->readOldest(sample_.data(), time, sequence))
+	{
+		char* dst = &chunk_[nbRecords * recordSize];
+		std::memcpy(dst, &time, sizeof(time));
+		std::memcpy(dst + sizeof(double), &sequence, sizeof(sequence));
+		std::memcpy(dst + 2 * sizeof(double), sample_.data(), sample_.size() * sizeof(double));
+		nbRecords++;
+	}
+
+	if (nbRecords > 0)
+	{
+		if (!writer_.writeChunk(chunk_.data(), static_cast<uint32_t>(nbRecords)))
+			std::cerr << "ERROR: EMG recording write failed." << std::endl;
+		written_.store(written_.load(std::memory_order_relaxed) + nbRecords, std::memory_order_relaxed);
+	}
+	return nbRecords;
+}
+
+void EMGRecorder::writerLoop()
+{
+	while (running_)
+	{
+		// Write full chunks while there is a backlog, otherwise let samples accumulate
+		if (drain() < chunkRecords_)
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+}
@@ -0,0 +1,167 @@
+#include "EMGRecordingFile.h"
+
+#include <cstring>
+
+namespace
+{
+	const char FILE_MAGIC[8] = { 'E', 'M', 'G', 'R', 'E', 'C', '1', '\0' };
+	const size_t WRITE_BUFFER_SIZE = 1 << 20;
+}
+
+EMGRecordingWriter::EMGRecordingWriter() : file_(nullptr), recordSize_(0)
+{
+}
+
+EMGRecordingWriter::~EMGRecordingWriter()
+{
+	close();
+}
+
+bool EMGRecordingWriter::open(const std::string& fileName, const std::vector<std::string>& channelNames)
+{
+	close();
+	file_ = fopen(fileName.c_str(), "wb");
+	if (file_ == nullptr)
+		return false;
+	setvbuf(file_, nullptr, _IOFBF, WRITE_BUFFER_SIZE);
+
+	const uint32_t nbChannel = static_cast<uint32_t>(channelNames.size());
+	const uint32_t flags = 0;
+	recordSize_ = (2 + 2 * channelNames.size()) * sizeof(double);
+
+	bool ok = fwrite(FILE_MAGIC, sizeof(FILE_MAGIC), 1, file_) == 1;
+	ok &= fwrite(&nbChannel, sizeof(nbChannel), 1, file_) == 1;
+	ok &= fwrite(&flags, sizeof(flags), 1, file_) == 1;
+	for (const std::string& name : channelNames)
+	{
+		const uint16_t length = static_cast<uint16_t>(name.size());
+		ok &= fwrite(&length, sizeof(length), 1, file_) == 1;
+		ok &= fwrite(name.data(), 1, length, file_) == length;
+	}
+	return ok;
+}
+
+bool EMGRecordingWriter::writeChunk(const char* records, uint32_t nbRecords)
+{
+	if (file_ == nullptr || nbRecords == 0)
+		return file_ != nullptr;
+	const uint32_t magic = CHUNK_MAGIC;
+	bool ok = fwrite(&magic, sizeof(magic), 1, file_) == 1;
+	ok &= fwrite(&nbRecords, sizeof(nbRecords), 1, file_) == 1;
+	ok &= fwrite(records, recordSize_, nbRecords, file_) == nbRecords;
+	// Handed to the OS chunk by chunk, so that a crash of the process loses at most the chunk being written
+	ok &= fflush(file_) == 0;
+	return ok;
+}
+
+void EMGRecordingWriter::close()
+{
+	if (file_ != nullptr)
+	{
+		fclose(file_);
+		file_ = nullptr;
+	}
+}
+
+EMGRecordingReader::EMGRecordingReader() : file_(nullptr), dataOffset_(0), recordSize_(0), chunkRecords_(0), chunkIndex_(0)
+{
+}
+
+EMGRecordingReader::~EMGRecordingReader()
+{
+	close();
+}
+
+bool EMGRecordingReader::open(const std::string& fileName)
+{
+	close();
+	file_ = fopen(fileName.c_str(), "rb");
+	if (file_ == nullptr)
+		return false;
+
+	char magic[8];
+	uint32_t nbChannel, flags;
+	if (fread(magic, sizeof(magic), 1, file_) != 1 || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0 ||
+		fread(&nbChannel, sizeof(nbChannel), 1, file_) != 1 || fread(&flags, sizeof(flags), 1, file_) != 1)
+	{
+		close();
+		return false;
+	}
+
+	channelNames_.clear();
+	for (uint32_t i = 0; i < nbChannel; ++i)
+	{
+		uint16_t length;
+		if (fread(&length, sizeof(length), 1, file_) != 1)
+		{
+			close();
+			return false;
+		}
+		std::string name(length, '\0');
+		if (length > 0 && fread(&name[0], 1, length, file_) != length)
+		{
+			close();
+			return false;
+		}
+		channelNames_.push_back(name);
+	}
+
+	recordSize_ = (2 + 2 * nbChannel) * sizeof(double);
+	dataOffset_ = ftell(file_);
+	chunkRecords_ = 0;
+	chunkIndex_ = 0;
+	return true;
+}
+
+bool EMGRecordingReader::readChunk()
+{
+	uint32_t magic, nbRecords;
+	if (fread(&magic, sizeof(magic), 1, file_) != 1 || magic != EMGRecordingWriter::CHUNK_MAGIC ||
+		fread(&nbRecords, sizeof(nbRecords), 1, file_) != 1)
+		return false;
+
+	chunk_.resize(nbRecords * recordSize_);
+	if (fread(chunk_.data(), recordSize_, nbRecords, file_) != nbRecords)
+		return false; // Truncated chunk
+	chunkRecords_ = nbRecords;
+	chunkIndex_ = 0;
+	return true;
+}
+
+bool EMGRecordingReader::next(EMGRecord& record)
+{
+	if (file_ == nullptr)
+		return false;
+	while (chunkIndex_ >= chunkRecords_)
+		if (!readChunk())
+			return false;
+
+	const size_t nbChannel = channelNames_.size();
+	const char* src = &chunk_[chunkIndex_ * recordSize_];
+	std::memcpy(&record.time, src, sizeof(double));
+	std::memcpy(&record.sequence, src + sizeof(double), sizeof(uint64_t));
+	record.raw.resize(nbChannel);
+	record.normalized.resize(nbChannel);
+	std::memcpy(record.raw.data(), src + 2 * sizeof(double), nbChannel * sizeof(double));
+	std::memcpy(record.normalized.data(), src + (2 + nbChannel) * sizeof(double), nbChannel * sizeof(double));
+	chunkIndex_++;
+	return true;
+}
+
+void EMGRecordingReader::rewind()
+{
+	if (file_ == nullptr)
+		return;
+	fseek(file_, dataOffset_, SEEK_SET);
+	chunkRecords_ = 0;
+	chunkIndex_ = 0;
+}
+
+void EMGRecordingReader::close()
+{
+	if (file_ != nullptr)
+	{
+		fclose(file_);
+		file_ = nullptr;
+	}
+}
@@ -0,0 +1,80 @@
+// Offline conversion of a binary EMG recording (.emgrec) to OpenSim storage files (.sto).
+// Usage: EMGRecordingToSto <recording.emgrec> [output prefix]
+// Writes <prefix>_normalized.sto (the values published to CEINMS-RT) and <prefix>_raw.sto.
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "EMGRecordingFile.h"
+
+namespace
+{
+	bool writeSto(EMGRecordingReader& reader, const std::string& fileName, const std::string& name, bool normalized)
+	{
+		// .sto needs the number of rows in its header
+		reader.rewind();
+		EMGRecord record;
+		size_t nbRows = 0;
+		while (reader.next(record))
+			nbRows++;
+
+		std::ofstream out(fileName.c_str());
+		if (!out)
+		{
+			std::cerr << "Cannot create " << fileName << std::endl;
+			return false;
+		}
+
+		const std::vector<std::string>& names = reader.getChannelNames();
+		out << name << std::endl;
+		out << "version=1" << std::endl;
+		out << "nRows=" << nbRows << std::endl;
+		out << "nColumns=" << names.size() + 1 << std::endl;
+		out << "inDegrees=no" << std::endl;
+		out << "endheader" << std::endl;
+		out << "time";
+		for (const std::string& channel : names)
+			out << "\t" << channel;
+		out << std::endl;
+
+		out << std::setprecision(12);
+		reader.rewind();
+		while (reader.next(record))
+		{
+			const std::vector<double>& values = normalized ? record.normalized : record.raw;
+			out << record.time;
+			for (double value : values)
+				out << "\t" << value;
+			out << "\n";
+		}
+		std::cout << "Wrote " << nbRows << " rows to " << fileName << std::endl;
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: " << argv[0] << " <recording.emgrec> [output prefix]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const std::string input = argv[1];
+	std::string prefix = argc > 2 ? argv[2] : input;
+	if (argc <= 2 && prefix.size() > 7 && prefix.compare(prefix.size() - 7, 7, ".emgrec") == 0)
+		prefix.erase(prefix.size() - 7);
+
+	EMGRecordingReader reader;
+	if (!reader.open(input))
+	{
+		std::cerr << "Cannot read EMG recording " << input << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	bool ok = writeSto(reader, prefix + "_normalized.sto", "EMG normalized", true);
+	ok &= writeSto(reader, prefix + "_raw.sto", "EMG raw", false);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
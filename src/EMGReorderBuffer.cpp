@@ -0,0 +1,215 @@
+#include "EMGReorderBuffer.h"
+
+#include <algorithm>
+#include <limits>
+
+EMGReorderBuffer::EMGReorderBuffer() : nbChannel_(0), maxDelay_(0.0), gapFill_(HOLD), started_(false), nextSequence_(0),
+	highestSequence_(0), lastWire_(0), hasReleased_(false), lastTime_(0.0), lastSequence_(0), readyHead_(0), readyCount_(0),
+	counters_()
+{
+}
+
+void EMGReorderBuffer::setup(size_t nbChannel, size_t window, double maxDelay, GapFill gapFill)
+{
+	nbChannel_ = nbChannel;
+	maxDelay_ = maxDelay;
+	gapFill_ = gapFill;
+	window = std::max<size_t>(window, 2);
+	Slot empty = { false, 0, 0.0, 0.0 };
+	slots_.assign(window, empty);
+	values_.assign(window * nbChannel_, 0.0);
+	lastValues_.assign(nbChannel_, 0.0);
+	fill_.assign(nbChannel_, 0.0);
+	started_ = false;
+	hasReleased_ = false;
+
+	// A push() can release the whole window and the sample that arrived
+	ready_.assign(2 * window * nbChannel_, 0.0);
+	readyTime_.assign(2 * window, 0.0);
+	readySequence_.assign(2 * window, 0);
+	readyFilled_.assign(2 * window, 0);
+	readyHead_ = 0;
+	readyCount_ = 0;
+	counters_ = Counters();
+}
+
+void EMGReorderBuffer::push(uint32_t wire, const double* data, double time, double now)
+{
+	counters_.received++;
+
+	// 64-bit sequence, the closest to the last one received
+	uint64_t sequence = wire;
+	if (!started_)
+	{
+		started_ = true;
+		nextSequence_ = sequence;
+		highestSequence_ = sequence;
+	}
+	else
+	{
+		const int64_t step = static_cast<int32_t>(wire - lastWire_);
+		const int64_t unwrapped = static_cast<int64_t>(highestSequence_) + step;
+		if (step < -static_cast<int64_t>(slots_.size()) || unwrapped < 0)
+		{
+			// Too far back to be a late packet: the sender restarted its numbering
+			restart();
+			nextSequence_ = sequence;
+			highestSequence_ = sequence;
+		}
+		else
+			sequence = static_cast<uint64_t>(unwrapped);
+	}
+	if (sequence >= highestSequence_)
+		lastWire_ = wire;
+
+	if (sequence < nextSequence_)
+	{
+		counters_.late++;
+		return;
+	}
+	if (isPresent(sequence))
+	{
+		counters_.duplicates++;
+		return;
+	}
+	if (sequence < highestSequence_)
+		counters_.reordered++;
+
+	if (sequence >= nextSequence_ + slots_.size())
+	{
+		// No room: the buffered samples are released with their gaps filled,
+		// what remains of the jump is too long to be filled
+		while (nextSequence_ <= highestSequence_ && sequence >= nextSequence_ + slots_.size())
+		{
+			releaseNext();
+			releaseInOrder();
+		}
+		if (sequence >= nextSequence_ + slots_.size())
+		{
+			counters_.lost += sequence - nextSequence_;
+			nextSequence_ = sequence;
+		}
+	}
+
+	Slot& slot = slots_[sequence % slots_.size()];
+	slot.present = true;
+	slot.sequence = sequence;
+	slot.time = time;
+	slot.arrival = now;
+	std::copy(data, data + nbChannel_, values_.begin() + (sequence % slots_.size()) * nbChannel_);
+	highestSequence_ = std::max(highestSequence_, sequence);
+
+	releaseInOrder();
+	expire(now);
+}
+
+void EMGReorderBuffer::restart()
+{
+	// The buffered samples are released with their gaps filled, none is left in a slot
+	while (nextSequence_ <= highestSequence_)
+	{
+		releaseNext();
+		releaseInOrder();
+	}
+	// No interpolation across the restart
+	hasReleased_ = false;
+	counters_.restarts++;
+}
+
+void EMGReorderBuffer::expire(double now)
+{
+	for (;;)
+	{
+		const double deadline = nextDeadline();
+		if (deadline < 0.0 || now < deadline)
+			return;
+		releaseNext();
+		releaseInOrder();
+	}
+}
+
+void EMGReorderBuffer::releaseInOrder()
+{
+	while (isPresent(nextSequence_))
+		releaseNext();
+}
+
+void EMGReorderBuffer::releaseNext()
+{
+	const size_t index = nextSequence_ % slots_.size();
+	Slot& slot = slots_[index];
+	if (slot.present && slot.sequence == nextSequence_)
+	{
+		slot.present = false;
+		release(&values_[index * nbChannel_], slot.time, false);
+		return;
+	}
+
+	// Lost, replaced using the next buffered sample
+	uint64_t next = nextSequence_ + 1;
+	while (!isPresent(next))
+		next++;
+	const Slot& after = slots_[next % slots_.size()];
+	const double* afterValues = &values_[(next % slots_.size()) * nbChannel_];
+	const double fraction = hasReleased_ ?
+		static_cast<double>(nextSequence_ - lastSequence_) / static_cast<double>(next - lastSequence_) : 1.0;
+
+	if (gapFill_ == NAN_MARK)
+		std::fill(fill_.begin(), fill_.end(), std::numeric_limits<double>::quiet_NaN());
+	else if (gapFill_ == HOLD && hasReleased_)
+		std::copy(lastValues_.begin(), lastValues_.end(), fill_.begin());
+	else
+		for (size_t i = 0; i < nbChannel_; ++i)
+			fill_[i] = hasReleased_ ? lastValues_[i] + fraction * (afterValues[i] - lastValues_[i]) : afterValues[i];
+	// The time stamp is interpolated whatever the policy
+	const double time = hasReleased_ ? lastTime_ + fraction * (after.time - lastTime_) : after.time;
+
+	counters_.lost++;
+	counters_.filled++;
+	release(fill_.data(), time, true);
+}
+
+void EMGReorderBuffer::release(const double* data, double time, bool filled)
+{
+	if (!filled || gapFill_ != NAN_MARK)
+		std::copy(data, data + nbChannel_, lastValues_.begin());
+	lastTime_ = time;
+	lastSequence_ = nextSequence_;
+	hasReleased_ = true;
+
+	// The output is read after every push(), a full queue only happens if pop() is never called
+	if (readyCount_ == readyTime_.size())
+	{
+		readyHead_ = (readyHead_ + 1) % readyTime_.size();
+		readyCount_--;
+	}
+	const size_t tail = (readyHead_ + readyCount_) % readyTime_.size();
+	std::copy(data, data + nbChannel_, ready_.begin() + tail * nbChannel_);
+	readyTime_[tail] = time;
+	readySequence_[tail] = nextSequence_;
+	readyFilled_[tail] = filled;
+	readyCount_++;
+	nextSequence_++;
+}
+
+bool EMGReorderBuffer::pop(double* data, double& time, uint64_t& sequence, bool& filled)
+{
+	if (readyCount_ == 0)
+		return false;
+	std::copy(ready_.begin() + readyHead_ * nbChannel_, ready_.begin() + (readyHead_ + 1) * nbChannel_, data);
+	time = readyTime_[readyHead_];
+	sequence = readySequence_[readyHead_];
+	filled = readyFilled_[readyHead_] != 0;
+	readyHead_ = (readyHead_ + 1) % readyTime_.size();
+	readyCount_--;
+	return true;
+}
+
+double EMGReorderBuffer::nextDeadline() const
+{
+	double deadline = -1.0;
+	for (const Slot& slot : slots_)
+		if (slot.present && (deadline < 0.0 || slot.arrival + maxDelay_ < deadline))
+			deadline = slot.arrival + maxDelay_;
+	return deadline;
+}
@@ -0,0 +1,92 @@
+// Stand-alone UDP sender replaying a recorded EMG session, in place of the Simulink sender.
+// Usage: EMGReplaySender <recording.sto|recording.emgrec> [ip] [port] [speed] [text|textseq|binary] [loop]
+// speed: 1 for real time (default), N for N times faster, 0 for as fast as possible.
+// textseq: text packets with their sequence number in front, 12["v1","v2",...].
+// The channels are sent in the order of the file, which is the order of the subject XML
+// for the recordings made by the plugin.
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "EMGBinaryPacket.h"
+#include "EMGReplaySource.h"
+#include "EMGTextParser.h"
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: " << argv[0] << " <recording.sto|recording.emgrec> [ip] [port] [speed] [text|textseq|binary] [loop]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const std::string fileName = argv[1];
+	const std::string ip = argc > 2 ? argv[2] : "127.0.0.1";
+	const int port = argc > 3 ? atoi(argv[3]) : 31000;
+	const double speed = argc > 4 ? atof(argv[4]) : 1.0;
+	const bool binary = argc > 5 && std::string(argv[5]) == "binary";
+	const bool textSequence = argc > 5 && std::string(argv[5]) == "textseq";
+	const bool loop = argc > 6 && std::string(argv[6]) == "loop";
+
+	EMGReplaySource source;
+	if (!source.open(fileName))
+	{
+		std::cerr << "Cannot read EMG recording " << fileName << std::endl;
+		return EXIT_FAILURE;
+	}
+	source.setPacing(speed, loop);
+
+	int sockFd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sockFd < 0)
+	{
+		std::cerr << "Failed to create UDP socket: " << strerror(errno) << std::endl;
+		return EXIT_FAILURE;
+	}
+	struct sockaddr_in destination;
+	memset(&destination, 0, sizeof(destination));
+	destination.sin_family = AF_INET;
+	destination.sin_port = htons(port);
+	if (inet_pton(AF_INET, ip.c_str(), &destination.sin_addr) <= 0)
+	{
+		std::cerr << "Invalid IP address: " << ip << std::endl;
+		close(sockFd);
+		return EXIT_FAILURE;
+	}
+
+	const size_t nbChannel = source.getChannelNames().size();
+	std::cout << "Replaying " << fileName << " (" << nbChannel << " channels) to " << ip << ":" << port << ", "
+		<< (binary ? "binary" : textSequence ? "numbered text" : "text") << " packets" << std::endl;
+
+	std::vector<double> sample(nbChannel);
+	std::vector<char> packet(EMGBinaryPacket::HEADER_SIZE + nbChannel * 32 + 16);
+	uint32_t sequence = 0;
+	uint64_t sent = 0, failed = 0;
+	double time;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while (source.next(sample.data(), time))
+	{
+		const size_t size = binary ?
+			EMGBinaryPacket::encode(packet.data(), packet.size(), sample.data(), nbChannel, sequence, time) :
+			EMGTextParser::format(packet.data(), packet.size(), sample.data(), nbChannel, textSequence ? sequence : -1);
+		sequence++;
+		if (size > 0 && sendto(sockFd, packet.data(), size, 0, (const struct sockaddr*)&destination, sizeof(destination)) == static_cast<ssize_t>(size))
+			sent++;
+		else
+			failed++;
+	}
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Sent " << sent << " packets in " << elapsed << " s (" << (elapsed > 0.0 ? sent / elapsed : 0.0) << " packets/s), "
+		<< failed << " failed" << std::endl;
+	close(sockFd);
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
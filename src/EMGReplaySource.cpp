@@ -0,0 +1,198 @@
+#include "EMGReplaySource.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+	bool endsWith(const std::string& value, const std::string& suffix)
+	{
+		return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	void split(const std::string& line, std::vector<std::string>& tokens)
+	{
+		tokens.clear();
+		size_t begin = line.find_first_not_of(" \t\r");
+		while (begin != std::string::npos)
+		{
+			const size_t end = line.find_first_of(" \t\r", begin);
+			tokens.push_back(line.substr(begin, end - begin));
+			begin = line.find_first_not_of(" \t\r", end);
+		}
+	}
+}
+
+EMGReplaySource::EMGReplaySource() : binary_(false), stoDataOffset_(0), speed_(1.0), loop_(false), started_(false),
+	firstTime_(0.0), timeOffset_(0.0), lastTime_(0.0), period_(0.0)
+{
+}
+
+bool EMGReplaySource::open(const std::string& fileName, const std::vector<std::string>& channelNames)
+{
+	close();
+	binary_ = endsWith(fileName, ".emgrec");
+	std::vector<std::string> fileNames;
+	if (binary_)
+	{
+		if (!recording_.open(fileName))
+			return false;
+		fileNames = recording_.getChannelNames();
+	}
+	else
+	{
+		sto_.open(fileName.c_str());
+		if (!sto_)
+			return false;
+
+		// Header lines up to endheader, then the column names
+		std::string line;
+		while (std::getline(sto_, line) && line.compare(0, 9, "endheader") != 0)
+		{
+		}
+		std::vector<std::string> columns;
+		if (!std::getline(sto_, line))
+			return false;
+		split(line, columns);
+		if (columns.empty() || columns[0] != "time")
+			return false;
+		fileNames.assign(columns.begin() + 1, columns.end());
+		stoDataOffset_ = sto_.tellg();
+		row_.resize(fileNames.size());
+	}
+
+	if (!mapChannels(fileNames, channelNames))
+	{
+		close();
+		return false;
+	}
+	rewind();
+	return true;
+}
+
+bool EMGReplaySource::mapChannels(const std::vector<std::string>& fileNames, const std::vector<std::string>& channelNames)
+{
+	channelNames_ = channelNames.empty() ? fileNames : channelNames;
+	columns_.clear();
+	for (const std::string& name : channelNames_)
+	{
+		size_t column = 0;
+		while (column < fileNames.size() && fileNames[column] != name)
+			column++;
+		if (column == fileNames.size())
+		{
+			std::cerr << "EMGReplaySource: channel " << name << " not found in the recording" << std::endl;
+			return false;
+		}
+		columns_.push_back(column);
+	}
+	return true;
+}
+
+void EMGReplaySource::setPacing(double speed, bool loop)
+{
+	speed_ = speed > 0.0 ? speed : 0.0;
+	loop_ = loop;
+}
+
+bool EMGReplaySource::readRow(double& time)
+{
+	if (binary_)
+	{
+		if (!recording_.next(record_))
+			return false;
+		time = record_.time;
+		return true;
+	}
+
+	while (std::getline(sto_, line_))
+	{
+		const char* p = line_.c_str();
+		char* end;
+		time = std::strtod(p, &end);
+		if (end == p)
+			continue; // Empty or trailing line
+		p = end;
+		for (double& value : row_)
+		{
+			value = std::strtod(p, &end);
+			p = end;
+		}
+		return true;
+	}
+	return false;
+}
+
+bool EMGReplaySource::read(double* data, double& time)
+{
+	double fileTime;
+	if (!readRow(fileTime))
+	{
+		if (!loop_ || !started_)
+			return false;
+		// Next loop: continue the time stamps one sample period after the last one
+		rewind();
+		started_ = true;
+		double firstTime;
+		if (!readRow(firstTime))
+			return false;
+		timeOffset_ = lastTime_ + period_ - firstTime;
+		fileTime = firstTime;
+	}
+
+	const std::vector<double>& values = binary_ ? record_.raw : row_;
+	for (size_t i = 0; i < columns_.size(); ++i)
+		data[i] = values[columns_[i]];
+
+	time = fileTime + timeOffset_;
+	if (!started_)
+	{
+		started_ = true;
+		firstTime_ = time;
+		origin_ = std::chrono::steady_clock::now();
+	}
+	else if (time > lastTime_)
+	{
+		period_ = time - lastTime_;
+	}
+	lastTime_ = time;
+	return true;
+}
+
+bool EMGReplaySource::next(double* data, double& time)
+{
+	if (!read(data, time))
+		return false;
+	if (speed_ > 0.0)
+	{
+		const std::chrono::duration<double> delay((time - firstTime_) / speed_);
+		std::this_thread::sleep_until(origin_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay));
+	}
+	return true;
+}
+
+void EMGReplaySource::rewind()
+{
+	if (binary_)
+	{
+		recording_.rewind();
+	}
+	else if (sto_.is_open())
+	{
+		sto_.clear();
+		sto_.seekg(stoDataOffset_);
+	}
+	started_ = false;
+	timeOffset_ = 0.0;
+}
+
+void EMGReplaySource::close()
+{
+	recording_.close();
+	if (sto_.is_open())
+		sto_.close();
+	sto_.clear();
+	channelNames_.clear();
+	columns_.clear();
+}
@@ -0,0 +1,145 @@
+#include "EMGResampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+EMGDecimator::EMGDecimator() : factor_(1), nbTaps_(1), nbChannel_(0), phase_(0), head_(0), count_(0)
+{
+}
+
+void EMGDecimator::setup(size_t factor, size_t nbTaps, size_t nbChannel)
+{
+	factor_ = factor > 0 ? factor : 1;
+	nbTaps_ = nbTaps > 0 ? nbTaps : 8 * factor_ + 1;
+	nbChannel_ = nbChannel;
+
+	// Windowed-sinc low-pass, cutoff at 80% of the output Nyquist frequency, Blackman window
+	const double pi = 3.14159265358979323846;
+	const double cutoff = 0.4 / factor_; // cycles per input sample
+	const double center = (nbTaps_ - 1) / 2.0;
+	coeffs_.resize(nbTaps_);
+	double sum = 0.0;
+	for (size_t k = 0; k < nbTaps_; ++k)
+	{
+		const double t = k - center;
+		const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * t) / (pi * t);
+		const double window = nbTaps_ > 1 ?
+			0.42 - 0.5 * std::cos(2.0 * pi * k / (nbTaps_ - 1)) + 0.08 * std::cos(4.0 * pi * k / (nbTaps_ - 1)) : 1.0;
+		coeffs_[k] = sinc * window;
+		sum += coeffs_[k];
+	}
+	for (size_t k = 0; k < nbTaps_; ++k)
+		coeffs_[k] /= sum;
+
+	history_.assign(nbTaps_ * nbChannel_, 0.0);
+	times_.assign(nbTaps_, 0.0);
+	reset();
+}
+
+void EMGDecimator::reset()
+{
+	std::fill(history_.begin(), history_.end(), 0.0);
+	std::fill(times_.begin(), times_.end(), 0.0);
+	phase_ = 0;
+	head_ = nbTaps_ - 1;
+	count_ = 0;
+}
+
+bool EMGDecimator::process(const double* in, double time, double* out, double& outTime)
+{
+	head_ = head_ + 1 == nbTaps_ ? 0 : head_ + 1;
+	std::copy(in, in + nbChannel_, history_.begin() + head_ * nbChannel_);
+	times_[head_] = time;
+	if (count_ < nbTaps_)
+	{
+		// Prime the history with the first sample to avoid the start-up ramp from 0
+		if (count_ == 0)
+			for (size_t k = 0; k < nbTaps_; ++k)
+				std::copy(in, in + nbChannel_, history_.begin() + k * nbChannel_);
+		count_++;
+	}
+
+	phase_++;
+	if (phase_ < factor_)
+		return false;
+	phase_ = 0;
+
+	// Only the decimated outputs are computed: out = sum_k h[k] x[n - k], vectorized over channels
+	std::fill(out, out + nbChannel_, 0.0);
+	size_t row = head_;
+	for (size_t k = 0; k < nbTaps_; ++k)
+	{
+		const double h = coeffs_[k];
+		const double* x = &history_[row * nbChannel_];
+		for (size_t i = 0; i < nbChannel_; ++i)
+			out[i] += h * x[i];
+		row = row == 0 ? nbTaps_ - 1 : row - 1;
+	}
+
+	// Linear phase: the output corresponds to the input (nbTaps - 1) / 2 samples back
+	const size_t delay = std::min((nbTaps_ - 1) / 2, count_ - 1);
+	outTime = times_[(head_ + nbTaps_ - delay) % nbTaps_];
+	return true;
+}
+
+EMGWindowReducer::EMGWindowReducer() : mode_(MEAN), nbChannel_(0), count_(0), timeSum_(0.0), lastTime_(0.0)
+{
+}
+
+void EMGWindowReducer::setup(Mode mode, size_t nbChannel)
+{
+	mode_ = mode;
+	nbChannel_ = nbChannel;
+	accumulator_.assign(nbChannel_, 0.0);
+	begin();
+}
+
+void EMGWindowReducer::begin()
+{
+	count_ = 0;
+	timeSum_ = 0.0;
+	lastTime_ = 0.0;
+}
+
+void EMGWindowReducer::add(const double* data, double time)
+{
+	if (count_ == 0)
+	{
+		std::copy(data, data + nbChannel_, accumulator_.begin());
+	}
+	else if (mode_ == MEAN)
+	{
+		for (size_t i = 0; i < nbChannel_; ++i)
+			accumulator_[i] += data[i];
+	}
+	else
+	{
+		// A NaN (a gap filled with nan) is kept until the end of the window, like the sum of the mean
+		for (size_t i = 0; i < nbChannel_; ++i)
+			if (data[i] > accumulator_[i] || data[i] != data[i])
+				accumulator_[i] = data[i];
+	}
+	count_++;
+	timeSum_ += time;
+	lastTime_ = time;
+}
+
+bool EMGWindowReducer::finish(double* out, double& time)
+{
+	if (count_ == 0)
+		return false;
+
+	if (mode_ == MEAN)
+	{
+		const double scale = 1.0 / count_;
+		for (size_t i = 0; i < nbChannel_; ++i)
+			out[i] = accumulator_[i] * scale;
+		time = timeSum_ * scale;
+	}
+	else
+	{
+		std::copy(accumulator_.begin(), accumulator_.end(), out);
+		time = lastTime_;
+	}
+	return true;
+}
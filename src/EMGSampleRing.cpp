@@ -0,0 +1,184 @@
+#include "EMGSampleRing.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the futex word has to be a plain 32-bit integer");
+
+	uint64_t nowNs()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+}
+
+EMGSampleRing::EMGSampleRing(size_t capacity, size_t nbChannel) :
+	nbChannel_(nbChannel), head_(0), pushed_(0), overruns_(0), overwritten_(0), tailCache_(0), overwrite_(false),
+	tail_(0), dropped_(0), popped_(0), headCache_(0), lastPublished_(0.0),
+	wakeup_(false), waiting_(0), signal_(0)
+{
+	capacity_ = 1;
+	while (capacity_ < capacity)
+		capacity_ <<= 1;
+	mask_ = capacity_ - 1;
+
+	const size_t slotSize = sizeof(SlotHeader) + nbChannel_ * sizeof(double);
+	stride_ = (slotSize + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+
+	storage_.resize(capacity_ * stride_ + CACHE_LINE);
+	void* aligned = storage_.data();
+	size_t space = storage_.size();
+	base_ = static_cast<char*>(std::align(CACHE_LINE, capacity_ * stride_, aligned, space));
+}
+
+bool EMGSampleRing::push(const double* data, double time, uint64_t sequence, double published)
+{
+	const uint64_t head = head_.load(std::memory_order_relaxed);
+	if (head - tailCache_ >= capacity_)
+	{
+		tailCache_ = tail_.load(std::memory_order_acquire);
+		if (head - tailCache_ >= capacity_)
+		{
+			if (!overwrite_)
+			{
+				overruns_.store(overruns_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				return false;
+			}
+			// Drop the oldest sample; a failed swap means the consumer freed a slot meanwhile.
+			// A consumer copying that slot sees tail_ move and reads again.
+			if (tail_.compare_exchange_strong(tailCache_, tailCache_ + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				tailCache_++;
+				overwritten_.store(overwritten_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	char* dst = slot(head);
+	SlotHeader header = { time, sequence, published };
+	std::memcpy(dst, &header, sizeof(header));
+	std::memcpy(dst + sizeof(SlotHeader), data, nbChannel_ * sizeof(double));
+
+	head_.store(head + 1, std::memory_order_release);
+	pushed_.store(pushed_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	// Pairs with the fence of waitForData(): either the consumer sees the new head, or this sees waiting_
+	if (wakeup_)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waiting_.load(std::memory_order_relaxed) != 0)
+		{
+			signal_.fetch_add(1, std::memory_order_release);
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&signal_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+		}
+	}
+	return true;
+}
+
+EMGSampleRing::WaitResult EMGSampleRing::waitForData(uint64_t spinNs, uint64_t timeoutNs)
+{
+	const uint64_t tail = tail_.load(std::memory_order_relaxed);
+	if (head_.load(std::memory_order_acquire) != tail)
+		return READY;
+
+	// A sample due within the spin time is read without a system call
+	const uint64_t start = nowNs();
+	const uint64_t spinEnd = start + (wakeup_ && spinNs < timeoutNs ? spinNs : timeoutNs);
+	uint64_t now = start;
+	while (now < spinEnd)
+	{
+		if (head_.load(std::memory_order_acquire) != tail)
+			return WOKEN;
+		now = nowNs();
+	}
+
+	const uint64_t deadline = start + timeoutNs;
+	while (now < deadline)
+	{
+		const uint32_t word = signal_.load(std::memory_order_acquire);
+		waiting_.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (head_.load(std::memory_order_acquire) != tail)
+		{
+			waiting_.store(0, std::memory_order_relaxed);
+			return WOKEN;
+		}
+		const uint64_t remaining = deadline - now;
+		struct timespec timeout;
+		timeout.tv_sec = static_cast<time_t>(remaining / 1000000000);
+		timeout.tv_nsec = static_cast<long>(remaining % 1000000000);
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&signal_), FUTEX_WAIT_PRIVATE, word, &timeout, nullptr, 0);
+		waiting_.store(0, std::memory_order_relaxed);
+		if (head_.load(std::memory_order_acquire) != tail)
+			return WOKEN;
+		now = nowNs();
+	}
+	return TIMEOUT;
+}
+
+void EMGSampleRing::copyOut(uint64_t index, double* data, double& time, uint64_t& sequence)
+{
+	const char* src = slot(index);
+	SlotHeader header;
+	std::memcpy(&header, src, sizeof(header));
+	std::memcpy(data, src + sizeof(SlotHeader), nbChannel_ * sizeof(double));
+	time = header.time;
+	sequence = header.sequence;
+	lastPublished_ = header.published;
+}
+
+bool EMGSampleRing::readOldest(double* data, double& time, uint64_t& sequence)
+{
+	uint64_t tail;
+	do
+	{
+		// Relaxed is enough without overwrite_, the consumer owns tail_
+		tail = tail_.load(overwrite_ ? std::memory_order_acquire : std::memory_order_relaxed);
+		// With overwrite_ the producer can move tail_ past a stale headCache_
+		if (tail >= headCache_)
+		{
+			headCache_ = head_.load(std::memory_order_acquire);
+			if (tail == headCache_)
+				return false;
+		}
+		copyOut(tail, data, time, sequence);
+	} while (!advanceTail(tail, tail + 1));
+	popped_.store(popped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return true;
+}
+
+bool EMGSampleRing::readLatest(double* data, double& time, uint64_t& sequence)
+{
+	uint64_t tail;
+	do
+	{
+		tail = tail_.load(overwrite_ ? std::memory_order_acquire : std::memory_order_relaxed);
+		headCache_ = head_.load(std::memory_order_acquire);
+		if (tail == headCache_)
+			return false;
+
+		// The producer cannot reach slot headCache_ - 1 while tail_ has not moved past it
+		copyOut(headCache_ - 1, data, time, sequence);
+	} while (!advanceTail(tail, headCache_));
+	dropped_.store(dropped_.load(std::memory_order_relaxed) + (headCache_ - 1 - tail), std::memory_order_relaxed);
+	popped_.store(popped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return true;
+}
+
+EMGSampleRing::Counters EMGSampleRing::getCounters() const
+{
+	Counters counters;
+	counters.pushed = pushed_.load(std::memory_order_relaxed);
+	counters.overruns = overruns_.load(std::memory_order_relaxed);
+	counters.dropped = dropped_.load(std::memory_order_relaxed) + overwritten_.load(std::memory_order_relaxed);
+	counters.popped = popped_.load(std::memory_order_relaxed);
+	return counters;
+}
@@ -0,0 +1,235 @@
+// Sequence number handling of the receive path: sender restarts, gaps and late samples
+// in the reorder buffer, the fan-in of several senders, the fragment reassembly and the
+// sequence metrics.
+// Returns non-zero and prints the failed checks, run by ctest.
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "EMGBinaryPacket.h"
+#include "EMGFanIn.h"
+#include "EMGFrameAssembler.h"
+#include "EMGMetrics.h"
+#include "EMGReorderBuffer.h"
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool condition, const char* test, const char* what)
+	{
+		if (condition)
+			return;
+		std::cerr << test << ": " << what << std::endl;
+		failures++;
+	}
+
+	void reorderRestart()
+	{
+		const char* test = "reorderRestart";
+		EMGReorderBuffer reorder;
+		reorder.setup(2, 16, 0.01, EMGReorderBuffer::HOLD);
+
+		double sample[2] = { 0.0, 0.0 };
+		double time;
+		uint64_t sequence;
+		bool filled;
+		size_t released = 0;
+		for (uint32_t i = 0; i < 100000; ++i)
+		{
+			sample[0] = i;
+			reorder.push(i, sample, i * 0.001, i * 0.001);
+			while (reorder.pop(sample, time, sequence, filled))
+				released++;
+		}
+		check(released == 100000, test, "in-order samples not all released");
+
+		// The sender starts over from 0, one sample out of order
+		released = 0;
+		uint64_t expected = 0;
+		bool ordered = true;
+		for (uint32_t i = 0; i < 5000; ++i)
+		{
+			const uint32_t wire = i % 100 == 1 ? i + 1 : (i % 100 == 2 ? i - 1 : i);
+			sample[0] = wire;
+			reorder.push(wire, sample, 100.0 + i * 0.001, 100.0 + i * 0.001);
+			while (reorder.pop(sample, time, sequence, filled))
+			{
+				ordered &= sequence == expected && sample[0] == static_cast<double>(expected) && !filled;
+				expected++;
+				released++;
+			}
+		}
+		check(released == 5000, test, "samples after the restart not all released");
+		check(ordered, test, "samples after the restart out of order or filled");
+		const EMGReorderBuffer::Counters& counters = reorder.getCounters();
+		check(counters.restarts == 1, test, "restart not counted once");
+		check(counters.late == 0, test, "samples after the restart counted as late");
+		check(counters.lost == 0, test, "samples lost");
+
+		// A late sample within the window is still discarded
+		sample[0] = 4990;
+		reorder.push(4990, sample, 106.0, 106.0);
+		check(!reorder.pop(sample, time, sequence, filled), test, "late sample released");
+		check(reorder.getCounters().late == 1 && reorder.getCounters().restarts == 1, test, "late sample taken as a restart");
+	}
+
+	// Two senders of 2 channels each, aligned frames, both restart their numbering or clock from 0
+	void fanInRestart(EMGFanIn::Alignment alignment)
+	{
+		const char* test = alignment == EMGFanIn::SEQUENCE ? "fanInRestart(SEQUENCE)" : "fanInRestart(SENDER_TIME)";
+		EMGFanIn fanIn;
+		fanIn.setup({ { 0, 1 }, { 2, 3 } }, 4, alignment, 0.00025, EMGFanIn::DROP, 0.01);
+		EMGMetrics metrics;
+
+		double values[2] = { 0.0, 0.0 };
+		double frame[4];
+		double time;
+		uint64_t sequence;
+		size_t published = 0;
+		double now = 0.0;
+		for (int run = 0; run < 2; ++run)
+		{
+			const uint64_t count = run == 0 ? 10000 : 2000;
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				now += 0.001;
+				for (size_t source = 0; source < 2; ++source)
+				{
+					values[0] = static_cast<double>(i);
+					fanIn.add(source, values, i, i * 0.001, now);
+				}
+				while (fanIn.pop(frame, time, sequence))
+				{
+					metrics.sequence(static_cast<uint32_t>(sequence));
+					published++;
+				}
+			}
+		}
+		check(published == 12000, test, "frames after the restart not all published");
+		const EMGMetrics::Snapshot snapshot = metrics.snapshot(EMGSampleRing::Counters());
+		check(snapshot.sequenceRestarts == (alignment == EMGFanIn::SEQUENCE ? 1u : 0u), test, "metrics restart count wrong");
+		check(snapshot.reordered == 0 && snapshot.sequenceGaps == 0, test, "frames after the restart counted as reordered or missing");
+		const EMGFanIn::Counters& counters = fanIn.getCounters();
+		check(counters.late == 0, test, "samples after the restart counted as late");
+		check(counters.dropped == 0, test, "frames dropped");
+		check(counters.restarts == 2, test, "restart not counted once per sender");
+	}
+
+	void metricsRestart()
+	{
+		const char* test = "metricsRestart";
+		EMGMetrics metrics;
+		for (uint32_t i = 0; i < 100000; ++i)
+			metrics.sequence(i);
+		// The sender starts over from 0 with one packet missing, then a late one within the window
+		for (uint32_t i = 0; i < 5000; ++i)
+			if (i != 10)
+				metrics.sequence(i);
+		metrics.sequence(4000);
+		const EMGMetrics::Snapshot snapshot = metrics.snapshot(EMGSampleRing::Counters());
+		check(snapshot.sequenceRestarts == 1, test, "restart not counted once");
+		check(snapshot.reordered == 1, test, "packets after the restart counted as reordered");
+		check(snapshot.sequenceGaps == 1, test, "gap after the restart not counted");
+	}
+
+	// Frames of 8 channels in 2 fragments, the sender restarts its numbering from 0
+	void frameAssemblerRestart()
+	{
+		const char* test = "frameAssemblerRestart";
+		const size_t nbChannel = 8;
+		EMGFrameAssembler assembler;
+		assembler.setup(nbChannel, 16, 0.01);
+
+		double values[nbChannel];
+		double frame[nbChannel];
+		char buffer[256];
+		size_t completed = 0;
+		bool intact = true;
+		double now = 0.0;
+		for (int run = 0; run < 2; ++run)
+		{
+			const uint32_t count = run == 0 ? 100000 : 5000;
+			for (uint32_t sequence = 0; sequence < count; ++sequence)
+			{
+				now += 0.001;
+				for (size_t i = 0; i < nbChannel; ++i)
+					values[i] = sequence + 0.125 * i;
+				for (size_t index = 0; index < 2; ++index)
+				{
+					const size_t size = EMGBinaryPacket::encodeFragment(buffer, sizeof(buffer), values, 4 * index, 4, nbChannel,
+						index, 2, sequence, now, EMGBinaryPacket::FLOAT64);
+					EMGPacketHeader header;
+					EMGBinaryPacket::decode(buffer, size, frame, nbChannel, header);
+					if (assembler.add(header, buffer, size, now, frame))
+					{
+						completed += run;
+						for (size_t i = 0; i < nbChannel; ++i)
+							intact &= frame[i] == values[i];
+					}
+				}
+				assembler.expire(now);
+			}
+		}
+		check(completed == 5000, test, "frames after the restart not all completed");
+		check(intact, test, "frame values changed");
+		const EMGFrameAssembler::Counters& counters = assembler.getCounters();
+		check(counters.late == 0, test, "fragments after the restart counted as late");
+		check(counters.restarts == 1, test, "restart not counted once");
+	}
+
+	// A duplicate fragment with other values, and a fragment with a bad index, must not change the frame
+	void frameAssemblerDuplicate()
+	{
+		const char* test = "frameAssemblerDuplicate";
+		const size_t nbChannel = 8;
+		EMGFrameAssembler assembler;
+		assembler.setup(nbChannel, 16, 0.01);
+
+		double values[nbChannel], other[nbChannel];
+		for (size_t i = 0; i < nbChannel; ++i)
+		{
+			values[i] = 0.125 * i;
+			other[i] = -1.0;
+		}
+		double frame[nbChannel];
+		char buffer[256];
+		EMGPacketHeader header;
+		size_t size = EMGBinaryPacket::encodeFragment(buffer, sizeof(buffer), values, 0, 4, nbChannel, 0, 2, 7, 0.0, EMGBinaryPacket::FLOAT64);
+		EMGBinaryPacket::decode(buffer, size, frame, nbChannel, header);
+		check(!assembler.add(header, buffer, size, 0.0, frame), test, "frame completed by its first fragment");
+
+		size = EMGBinaryPacket::encodeFragment(buffer, sizeof(buffer), other, 0, 4, nbChannel, 0, 2, 7, 0.0, EMGBinaryPacket::FLOAT64);
+		check(!assembler.add(header, buffer, size, 0.0, frame), test, "duplicate fragment completed the frame");
+		size = EMGBinaryPacket::encodeFragment(buffer, sizeof(buffer), other, 0, 4, nbChannel, 1, 2, 7, 0.0, EMGBinaryPacket::FLOAT64);
+		buffer[EMGBinaryPacket::HEADER_SIZE + 4] = 2;
+		check(!assembler.add(header, buffer, size, 0.0, frame), test, "fragment with a bad index completed the frame");
+
+		size = EMGBinaryPacket::encodeFragment(buffer, sizeof(buffer), values, 4, 4, nbChannel, 1, 2, 7, 0.0, EMGBinaryPacket::FLOAT64);
+		check(assembler.add(header, buffer, size, 0.0, frame), test, "frame not completed");
+		bool intact = true;
+		for (size_t i = 0; i < nbChannel; ++i)
+			intact &= frame[i] == values[i];
+		check(intact, test, "frame values changed by a rejected fragment");
+		const EMGFrameAssembler::Counters& counters = assembler.getCounters();
+		check(counters.late == 1 && counters.invalid == 1, test, "rejected fragments not counted");
+	}
+}
+
+int main()
+{
+	reorderRestart();
+	fanInRestart(EMGFanIn::SEQUENCE);
+	fanInRestart(EMGFanIn::SENDER_TIME);
+	frameAssemblerRestart();
+	frameAssemblerDuplicate();
+	metricsRestart();
+	if (failures > 0)
+	{
+		std::cerr << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "EMGSequenceTest: all checks passed" << std::endl;
+	return 0;
+}
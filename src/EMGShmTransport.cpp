@@ -0,0 +1,180 @@
+#include "EMGShmTransport.h"
+#include "EMGShmRing.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+EMGShmTransport::EMGShmTransport() : base_(nullptr), size_(0), nbChannel_(0), capacity_(0), readIndex_(0), counters_()
+{
+}
+
+EMGShmTransport::~EMGShmTransport()
+{
+	close();
+}
+
+bool EMGShmTransport::create(const std::string& name, size_t nbChannel, size_t capacity)
+{
+	close();
+	capacity_ = 1;
+	while (capacity_ < capacity)
+		capacity_ <<= 1;
+	nbChannel_ = nbChannel;
+	size_ = emg_shm_size(nbChannel_, capacity_);
+
+	const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		const int error = errno;
+		::close(fd);
+		errno = error;
+		return false;
+	}
+	const bool sameSize = static_cast<size_t>(info.st_size) == size_;
+	if (!sameSize && ftruncate(fd, size_) != 0)
+	{
+		const int error = errno;
+		::close(fd);
+		errno = error;
+		return false;
+	}
+	void* base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (base == MAP_FAILED)
+		return false;
+	base_ = static_cast<unsigned char*>(base);
+
+	EMGShmHeader* header = emg_shm_header(base_);
+	const bool compatible = sameSize && __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == EMG_SHM_MAGIC &&
+		header->version == EMG_SHM_VERSION && header->nbChannel == nbChannel_ && header->capacity == capacity_ &&
+		header->slotSize == emg_shm_slot_size(nbChannel_);
+	if (compatible)
+	{
+		// An attached producer goes on, only the samples written from now on are read
+		readIndex_ = __atomic_load_n(emg_shm_write_index(base_), __ATOMIC_ACQUIRE);
+	}
+	else
+	{
+		// New layout, the magic number is written last: producers attach once it is complete
+		__atomic_store_n(&header->magic, 0u, __ATOMIC_RELEASE);
+		std::memset(base_ + sizeof(uint32_t), 0, size_ - sizeof(uint32_t));
+		header->version = EMG_SHM_VERSION;
+		header->nbChannel = static_cast<uint16_t>(nbChannel_);
+		header->capacity = static_cast<uint32_t>(capacity_);
+		header->slotSize = static_cast<uint32_t>(emg_shm_slot_size(nbChannel_));
+		__atomic_store_n(&header->magic, EMG_SHM_MAGIC, __ATOMIC_RELEASE);
+		readIndex_ = 0;
+	}
+	__atomic_store_n(&header->consumerWaiting, 0u, __ATOMIC_RELAXED);
+	counters_ = Counters();
+	return true;
+}
+
+void EMGShmTransport::close()
+{
+	if (base_ != nullptr)
+		munmap(base_, size_);
+	base_ = nullptr;
+}
+
+uint64_t EMGShmTransport::nowNs()
+{
+	return emg_shm_now_ns();
+}
+
+bool EMGShmTransport::available() const
+{
+	return __atomic_load_n(emg_shm_write_index(base_), __ATOMIC_ACQUIRE) != readIndex_;
+}
+
+bool EMGShmTransport::read(double* data, uint32_t& sequence, double& time, uint64_t& writeNs)
+{
+	for (;;)
+	{
+		const uint64_t written = __atomic_load_n(emg_shm_write_index(base_), __ATOMIC_ACQUIRE);
+		if (written == readIndex_)
+			return false;
+		if (written - readIndex_ > capacity_)
+		{
+			// Lapped by the producer
+			counters_.overruns += written - readIndex_ - capacity_;
+			readIndex_ = written - capacity_;
+		}
+
+		// Seqlock read: the stamp must be the one of the complete sample before and after the copy
+		const EMGShmSlot* slot = emg_shm_slot(base_, readIndex_);
+		const uint64_t expected = 2 * readIndex_ + 2;
+		const uint64_t before = __atomic_load_n(&slot->stamp, __ATOMIC_ACQUIRE);
+		if (before == expected)
+		{
+			sequence = slot->sequence;
+			writeNs = slot->writeNs;
+			time = slot->time;
+			std::memcpy(data, slot + 1, nbChannel_ * sizeof(double));
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&slot->stamp, __ATOMIC_RELAXED) == expected)
+			{
+				readIndex_++;
+				counters_.samples++;
+				return true;
+			}
+		}
+		// Overwritten while being read
+		counters_.overruns++;
+		readIndex_++;
+	}
+}
+
+void EMGShmTransport::wait(uint64_t spinNs, int timeoutMs)
+{
+	if (spinNs > 0)
+	{
+		const uint64_t end = nowNs() + spinNs;
+		do
+		{
+			for (int i = 0; i < 64; ++i)
+			{
+				if (available())
+					return;
+#if defined(__x86_64__) || defined(__i386__)
+				__builtin_ia32_pause();
+#endif
+			}
+		} while (nowNs() < end);
+	}
+
+	// Announce the sleep, then check again: either the producer sees the flag or we see its sample
+	EMGShmHeader* header = emg_shm_header(base_);
+	uint32_t* futexWord = emg_shm_futex(base_);
+	__atomic_store_n(&header->consumerWaiting, 1u, __ATOMIC_SEQ_CST);
+	const uint32_t word = __atomic_load_n(futexWord, __ATOMIC_SEQ_CST);
+	if (!available())
+	{
+		struct timespec timeout;
+		timeout.tv_sec = timeoutMs / 1000;
+		timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+		counters_.sleeps++;
+		syscall(SYS_futex, futexWord, FUTEX_WAIT, word, timeoutMs >= 0 ? &timeout : nullptr, nullptr, 0);
+	}
+	__atomic_store_n(&header->consumerWaiting, 0u, __ATOMIC_RELAXED);
+}
+
+void EMGShmTransport::wake()
+{
+	if (base_ == nullptr)
+		return;
+	uint32_t* futexWord = emg_shm_futex(base_);
+	__atomic_add_fetch(futexWord, 1, __ATOMIC_RELEASE);
+	syscall(SYS_futex, futexWord, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
@@ -0,0 +1,164 @@
+#include "EMGTelemetry.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+EMGTelemetry::EMGTelemetry(size_t capacity) : nbChannel_(0), slotSize_(0), decimation_(1), ticks_(0), writeIndex_(0), readIndex_(0),
+	sockFd_(-1), address_(), running_(false), sent_(0), overwritten_(0), errors_(0)
+{
+	capacity_ = 1;
+	while (capacity_ < capacity)
+		capacity_ <<= 1;
+}
+
+EMGTelemetry::~EMGTelemetry()
+{
+	stop();
+}
+
+bool EMGTelemetry::start(const std::string& ip, int port, size_t nbChannel, size_t decimation)
+{
+	stop();
+	if (HEADER_SIZE + 2 * nbChannel * sizeof(double) > MAX_DATAGRAM)
+		return false;
+	std::memset(&address_, 0, sizeof(address_));
+	address_.sin_family = AF_INET;
+	address_.sin_port = htons(static_cast<uint16_t>(port));
+	if (inet_pton(AF_INET, ip.c_str(), &address_.sin_addr) != 1)
+		return false;
+	sockFd_ = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sockFd_ < 0)
+		return false;
+
+	nbChannel_ = nbChannel;
+	decimation_ = decimation > 0 ? decimation : 1;
+	ticks_ = 0;
+	slotSize_ = (sizeof(SlotHeader) + 2 * nbChannel_ * sizeof(double) + 63) / 64 * 64;
+	slots_.assign(capacity_ * slotSize_, 0);
+	datagram_.assign(HEADER_SIZE + 2 * nbChannel_ * sizeof(double), 0);
+	writeIndex_ = 0;
+	readIndex_ = 0;
+	sent_ = 0;
+	overwritten_ = 0;
+	errors_ = 0;
+	running_ = true;
+	senderThread_ = std::thread(&EMGTelemetry::senderLoop, this);
+	return true;
+}
+
+void EMGTelemetry::stop()
+{
+	if (!running_)
+		return;
+	running_ = false;
+	if (senderThread_.joinable())
+		senderThread_.join();
+	drain();
+	close(sockFd_);
+	sockFd_ = -1;
+}
+
+void EMGTelemetry::push(const double* normalized, const double* maxAmp, double time, uint64_t sequence, const Health& health)
+{
+	// Seqlock write: odd stamp while the slot is inconsistent, nobody waits for the sender
+	const uint64_t index = writeIndex_.load(std::memory_order_relaxed);
+	unsigned char* dst = slot(index);
+	SlotHeader* header = reinterpret_cast<SlotHeader*>(dst);
+	__atomic_store_n(&header->stamp, 2 * index + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	header->sequence = sequence;
+	header->time = time;
+	header->health = health;
+	std::memcpy(dst + sizeof(SlotHeader), normalized, nbChannel_ * sizeof(double));
+	std::memcpy(dst + sizeof(SlotHeader) + nbChannel_ * sizeof(double), maxAmp, nbChannel_ * sizeof(double));
+	__atomic_store_n(&header->stamp, 2 * index + 2, __ATOMIC_RELEASE);
+	writeIndex_.store(index + 1, std::memory_order_release);
+}
+
+bool EMGTelemetry::read()
+{
+	for (;;)
+	{
+		const uint64_t written = writeIndex_.load(std::memory_order_acquire);
+		if (written == readIndex_)
+			return false;
+		if (written - readIndex_ > capacity_)
+		{
+			// Lapped by the receive thread, the oldest samples are gone
+			overwritten_.store(overwritten_.load(std::memory_order_relaxed) + written - readIndex_ - capacity_, std::memory_order_relaxed);
+			readIndex_ = written - capacity_;
+		}
+
+		// Copied straight into the datagram, kept only if the stamp did not change during the copy
+		const unsigned char* src = slot(readIndex_);
+		const SlotHeader* header = reinterpret_cast<const SlotHeader*>(src);
+		const uint64_t expected = 2 * readIndex_ + 2;
+		if (__atomic_load_n(&header->stamp, __ATOMIC_ACQUIRE) == expected)
+		{
+			Health health = header->health;
+			const uint64_t sequence = header->sequence;
+			const double time = header->time;
+			std::memcpy(&datagram_[HEADER_SIZE], src + sizeof(SlotHeader), 2 * nbChannel_ * sizeof(double));
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&header->stamp, __ATOMIC_RELAXED) == expected)
+			{
+				readIndex_++;
+				const uint32_t magic = MAGIC;
+				const uint16_t version = VERSION;
+				const uint16_t nbChannel = static_cast<uint16_t>(nbChannel_);
+				health.overwritten = overwritten_.load(std::memory_order_relaxed);
+				std::memcpy(&datagram_[0], &magic, sizeof(magic));
+				std::memcpy(&datagram_[4], &version, sizeof(version));
+				std::memcpy(&datagram_[6], &nbChannel, sizeof(nbChannel));
+				std::memcpy(&datagram_[8], &sequence, sizeof(sequence));
+				std::memcpy(&datagram_[16], &time, sizeof(time));
+				std::memcpy(&datagram_[24], &health, sizeof(health));
+				return true;
+			}
+		}
+		// Overwritten while being read
+		overwritten_.store(overwritten_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		readIndex_++;
+	}
+}
+
+size_t EMGTelemetry::drain()
+{
+	size_t nbSent = 0;
+	while (read())
+	{
+		// Never blocks: a full socket buffer or an unreachable monitor only loses this datagram
+		if (sendto(sockFd_, datagram_.data(), datagram_.size(), MSG_DONTWAIT,
+			reinterpret_cast<const struct sockaddr*>(&address_), sizeof(address_)) < 0)
+		{
+			errors_.store(errors_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			continue;
+		}
+		nbSent++;
+	}
+	sent_.store(sent_.load(std::memory_order_relaxed) + nbSent, std::memory_order_relaxed);
+	return nbSent;
+}
+
+void EMGTelemetry::senderLoop()
+{
+	while (running_)
+	{
+		// The receive thread makes no system call to wake the sender, it polls
+		drain();
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+}
+
+EMGTelemetry::Counters EMGTelemetry::getCounters() const
+{
+	Counters counters;
+	counters.sent = sent_.load(std::memory_order_relaxed);
+	counters.overwritten = overwritten_.load(std::memory_order_relaxed);
+	counters.errors = errors_.load(std::memory_order_relaxed);
+	return counters;
+}
@@ -0,0 +1,201 @@
+#include "EMGTextParser.h"
+
+#include <charconv>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+namespace
+{
+	// Characters skipped between two values: the whitespace of the C locale plus '"' and ','.
+	struct SeparatorTable
+	{
+		bool value[256];
+
+		SeparatorTable() : value()
+		{
+			const char separators[] = { ' ', '\t', '\n', '\v', '\f', '\r', '"', ',' };
+			for (char c : separators)
+				value[static_cast<unsigned char>(c)] = true;
+		}
+	};
+
+	const SeparatorTable SEPARATOR;
+
+	inline bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	// memchr/memrchr/strnlen are the vectorized (SSE2/AVX2) byte scanners of the C library.
+	inline const char* findLast(const char* buffer, char c, size_t size)
+	{
+#if defined(__GLIBC__)
+		return static_cast<const char*>(memrchr(buffer, c, size));
+#else
+		for (const char* p = buffer + size; p != buffer; --p)
+			if (*(p - 1) == c)
+				return p - 1;
+		return nullptr;
+#endif
+	}
+}
+
+EMGTextParser::EMGTextParser()
+{
+	resetCounters();
+}
+
+void EMGTextParser::resetCounters()
+{
+	counters_.packets = 0;
+	counters_.malformed = 0;
+	counters_.incomplete = 0;
+	counters_.invalidValues = 0;
+}
+
+bool EMGTextParser::parse(const char* buffer, size_t size, double* data, size_t nbChannel)
+{
+	counters_.packets++;
+
+	// The datagram used to be read as a C string, stop at the first '\0'
+	const char* nul = static_cast<const char*>(std::memchr(buffer, '\0', size));
+	if (nul != nullptr)
+		size = nul - buffer;
+
+	const char* first = static_cast<const char*>(std::memchr(buffer, '[', size));
+	const char* last = findLast(buffer, ']', size);
+	if (first == nullptr || last == nullptr || last <= first)
+	{
+		counters_.malformed++;
+		for (size_t i = 0; i < nbChannel; ++i)
+			data[i] = 0.0;
+		return false;
+	}
+
+	const char* p = first + 1;
+	size_t iLoc = 0;
+	while (iLoc < nbChannel)
+	{
+		while (p < last && SEPARATOR.value[static_cast<unsigned char>(*p)])
+			++p;
+		if (p == last)
+			break;
+
+		double value;
+		const char* next = parseNumber(p, last, value);
+		if (next == nullptr)
+		{
+			counters_.invalidValues++;
+			break;
+		}
+		data[iLoc] = value;
+		iLoc++;
+		p = next;
+	}
+
+	if (iLoc < nbChannel)
+	{
+		counters_.incomplete++;
+		for (; iLoc < nbChannel; ++iLoc)
+			data[iLoc] = 0.0;
+	}
+	return true;
+}
+
+const char* EMGTextParser::parseNumber(const char* begin, const char* end, double& value)
+{
+	// std::from_chars does not take a leading '+' but accepts "inf"/"nan",
+	// std::num_get is the opposite: the sign is handled here and the mantissa
+	// has to start with a digit or a decimal point.
+	const char* start = begin;
+	const char* mantissa = begin;
+	if (*begin == '+')
+	{
+		start = begin + 1;
+		mantissa = start;
+	}
+	else if (*begin == '-')
+	{
+		mantissa = begin + 1;
+	}
+	if (mantissa >= end || !(isDigit(*mantissa) || *mantissa == '.'))
+		return nullptr;
+
+	std::from_chars_result result = std::from_chars(start, end, value);
+	if (result.ec == std::errc::invalid_argument)
+		return nullptr;
+
+	// std::num_get consumes a dangling exponent ("1e", "1e+") and then fails on it
+	if (result.ptr < end && (*result.ptr == 'e' || *result.ptr == 'E'))
+	{
+		bool hasExponent = false;
+		for (const char* c = start; c != result.ptr; ++c)
+			hasExponent |= (*c == 'e' || *c == 'E');
+		if (!hasExponent)
+			return nullptr;
+	}
+
+	if (result.ec == std::errc::result_out_of_range)
+	{
+		// Rare path: overflow fails but underflow gives a (sub)normal value with std::num_get,
+		// let the stream decide so the accepted inputs stay identical.
+		std::istringstream iss(std::string(begin, result.ptr));
+		if (!(iss >> value))
+			return nullptr;
+	}
+	return result.ptr;
+}
+
+bool EMGTextParser::parseSequence(const char* buffer, size_t size, uint32_t& sequence)
+{
+	const char* first = static_cast<const char*>(std::memchr(buffer, '[', size));
+	if (first == nullptr)
+		return false;
+	const char* p = buffer;
+	while (p < first && SEPARATOR.value[static_cast<unsigned char>(*p)])
+		++p;
+	const std::from_chars_result result = std::from_chars(p, first, sequence);
+	if (result.ec != std::errc())
+		return false;
+	for (p = result.ptr; p < first; ++p)
+		if (!SEPARATOR.value[static_cast<unsigned char>(*p)])
+			return false;
+	return true;
+}
+
+size_t EMGTextParser::format(char* buffer, size_t bufferSize, const double* data, size_t nbChannel, int64_t sequence)
+{
+	char* p = buffer;
+	char* const end = buffer + bufferSize;
+	if (sequence >= 0)
+	{
+		const std::to_chars_result result = std::to_chars(p, end, static_cast<uint32_t>(sequence));
+		if (result.ec != std::errc())
+			return 0;
+		p = result.ptr;
+	}
+	if (p == end)
+		return 0;
+	*p++ = '[';
+	for (size_t i = 0; i < nbChannel; ++i)
+	{
+		if (end - p < 2)
+			return 0;
+		if (i > 0)
+			*p++ = ',';
+		*p++ = '"';
+		const std::to_chars_result result = std::to_chars(p, end, data[i]);
+		if (result.ec != std::errc())
+			return 0;
+		p = result.ptr;
+		if (p == end)
+			return 0;
+		*p++ = '"';
+	}
+	if (p == end)
+		return 0;
+	*p++ = ']';
+	return p - buffer;
+}
@@ -0,0 +1,199 @@
+// Property test of EMGTextParser against the former std::istringstream parser: on
+// formatted, mutated and random datagrams, both accept the same packets and produce
+// bit-identical values. Usage: EMGTextParserTest [iterations] [seed], run by ctest.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "EMGTextParser.h"
+
+#include "EMGLegacyParser.h"
+
+namespace
+{
+	// Characters of the format, of numbers and a few that are neither
+	const char ALPHABET[] = "[]\",. \t\n\r0123456789eE+-xXaAfFiInN#;:\0";
+
+	int failures = 0;
+
+	std::string printable(const std::string& packet)
+	{
+		std::string text;
+		for (char c : packet)
+		{
+			if (c == '\0')
+				text += "\\0";
+			else if (c == '\n')
+				text += "\\n";
+			else
+				text += c;
+		}
+		return text;
+	}
+
+	bool sameBits(double a, double b)
+	{
+		return std::memcmp(&a, &b, sizeof(double)) == 0;
+	}
+
+	/**
+	* Parse with both parsers and report the first difference.
+	*/
+	void compare(const std::string& packet, size_t nbChannel, const char* kind)
+	{
+		// The plugin null-terminates the datagram, the legacy parser reads a C string
+		std::string buffer = packet;
+		std::vector<double> legacy(nbChannel, -1.0);
+		const bool legacyValid = legacyParse(buffer.c_str(), legacy);
+
+		EMGTextParser parser;
+		std::vector<double> values(nbChannel, -1.0);
+		const bool valid = parser.parse(buffer.data(), buffer.size(), values.data(), nbChannel);
+
+		bool same = valid == legacyValid;
+		for (size_t i = 0; same && i < nbChannel; ++i)
+			same = sameBits(values[i], legacy[i]);
+		if (same)
+			return;
+		if (++failures <= 20)
+		{
+			std::cerr << kind << " packet '" << printable(packet) << "', " << nbChannel << " channels: ";
+			if (valid != legacyValid)
+				std::cerr << (valid ? "valid" : "malformed") << " instead of " << (legacyValid ? "valid" : "malformed");
+			else
+			{
+				size_t i = 0;
+				while (sameBits(values[i], legacy[i]))
+					i++;
+				std::cerr << "channel " << i << " " << values[i] << " instead of " << legacy[i];
+			}
+			std::cerr << std::endl;
+		}
+	}
+
+	double randomValue(std::mt19937_64& random)
+	{
+		switch (random() % 8)
+		{
+		case 0:
+			return 0.0;
+		case 1:
+			return -0.0;
+		case 2:
+			return std::numeric_limits<double>::denorm_min() * static_cast<double>(random() % 1000);
+		case 3:
+			return std::numeric_limits<double>::max() / static_cast<double>(1 + random() % 1000);
+		case 4:
+		{
+			// Any finite bit pattern
+			uint64_t bits = random();
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value == value && value - value == 0.0 ? value : 1.0;
+		}
+		default:
+			return std::uniform_real_distribution<double>(-1.0e-3, 1.0e-3)(random);
+		}
+	}
+
+	std::string formatted(std::mt19937_64& random, size_t nbValue)
+	{
+		std::vector<double> values(nbValue);
+		for (double& value : values)
+			value = randomValue(random);
+		std::vector<char> buffer(nbValue * 32 + 32);
+		const int64_t sequence = random() % 2 ? static_cast<int64_t>(random() % 100000) : -1;
+		const size_t size = EMGTextParser::format(buffer.data(), buffer.size(), values.data(), nbValue, sequence);
+		return std::string(buffer.data(), size);
+	}
+
+	void mutate(std::mt19937_64& random, std::string& packet)
+	{
+		const size_t nbMutation = 1 + random() % 4;
+		for (size_t m = 0; m < nbMutation; ++m)
+		{
+			const char c = ALPHABET[random() % (sizeof(ALPHABET) - 1)];
+			const size_t position = packet.empty() ? 0 : random() % (packet.size() + 1);
+			switch (random() % 5)
+			{
+			case 0:
+				packet.insert(position, 1, c);
+				break;
+			case 1:
+				if (position < packet.size())
+					packet[position] = c;
+				break;
+			case 2:
+				if (position < packet.size())
+					packet.erase(position, 1 + random() % 3);
+				break;
+			case 3:
+				// Repeated piece, number fragments next to each other
+				if (position < packet.size())
+					packet.insert(position, packet.substr(position, 1 + random() % 8));
+				break;
+			default:
+				packet.resize(position);
+				break;
+			}
+		}
+	}
+
+	std::string randomPacket(std::mt19937_64& random)
+	{
+		std::string packet(random() % 40, ' ');
+		for (char& c : packet)
+			c = ALPHABET[random() % (sizeof(ALPHABET) - 1)];
+		if (random() % 2)
+			packet = "[" + packet + "]";
+		return packet;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+	const uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+
+	// Boundaries of the number grammar and of the format
+	const char* const edges[] = { "", "[", "]", "][", "[]", "[ ]", "[\"\"]", "[,,,]", "[1", "1]", "[1]]", "[[1]",
+		"[1e999]", "[-1e999]", "[1e-400]", "[2.4703282292062328e-324]", "[1.7976931348623157e308]", "[1e]", "[1e+]",
+		"[1e-]", "[.]", "[.5]", "[5.]", "[-.5e-2]", "[+1]", "[++1]", "[-]", "[--1]", "[1-2]", "[1e5e5]", "[1.2.3]",
+		"[0x10]", "[0X1p3]", "[nan]", "[inf]", "[-inf]", "[infinity]", "[1,nan,2]", "[00012]", "[1\"2\"3]",
+		"[\"1\",\"2\",\"3\"]", "12[\"1\",\"2\"]", "[1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18]",
+		"[0.000000000000000000000000000000000000000000000000000000000001]", "[1e0000000000000000000000000001]",
+		"[123456789012345678901234567890]", "[1 ] 2]" };
+	for (const char* edge : edges)
+		for (size_t nbChannel : { 1, 4, 16 })
+			compare(edge, nbChannel, "edge");
+	// Parsing stops at a '\0' inside the datagram
+	compare(std::string("[1\0" "2]", 5), 4, "edge");
+	compare(std::string("[1 2]\0" "3]", 7), 4, "edge");
+
+	std::mt19937_64 random(seed);
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		const size_t nbChannel = 1 + random() % 20;
+		// More, as many or fewer values than channels
+		const size_t nbValue = random() % (2 * nbChannel + 1);
+		std::string packet = formatted(random, nbValue);
+		compare(packet, nbChannel, "formatted");
+		mutate(random, packet);
+		compare(packet, nbChannel, "mutated");
+		compare(randomPacket(random), nbChannel, "random");
+	}
+
+	if (failures > 0)
+	{
+		std::cerr << failures << " packets parsed differently, seed " << seed << std::endl;
+		return 1;
+	}
+	std::cout << "EMGTextParserTest: " << 3 * iterations << " packets parsed as the former parser, seed " << seed << std::endl;
+	return 0;
+}
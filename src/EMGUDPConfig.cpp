@@ -0,0 +1,605 @@
+#include "EMGUDPConfig.h"
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+#include <xercesc/parsers/XercesDOMParser.hpp>
+#include <xercesc/dom/DOM.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLException.hpp>
+
+namespace
+{
+	std::string toString(const XMLCh* xmlString)
+	{
+		if (xmlString == nullptr)
+			return std::string();
+		char* cString = xercesc::XMLString::transcode(xmlString);
+		std::string result(cString);
+		xercesc::XMLString::release(&cString);
+		return result;
+	}
+
+	std::string trim(const std::string& str)
+	{
+		size_t first = str.find_first_not_of(" \t\r\n");
+		if (first == std::string::npos)
+			return std::string();
+		size_t last = str.find_last_not_of(" \t\r\n");
+		return str.substr(first, last - first + 1);
+	}
+
+	std::string toLower(std::string str)
+	{
+		std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return std::tolower(c); });
+		return str;
+	}
+
+	// Walk down the child elements following a path such as "calibration/window".
+	const xercesc::DOMElement* findElement(const xercesc::DOMElement* root, const std::string& path)
+	{
+		const xercesc::DOMElement* current = root;
+		std::istringstream iss(path);
+		std::string name;
+		while (current != nullptr && std::getline(iss, name, '/'))
+		{
+			const xercesc::DOMElement* child = current->getFirstElementChild();
+			while (child != nullptr && toString(child->getTagName()) != name)
+				child = child->getNextElementSibling();
+			current = child;
+		}
+		return current;
+	}
+
+	bool getValue(const xercesc::DOMElement* root, const std::string& path, std::string& value)
+	{
+		const xercesc::DOMElement* element = findElement(root, path);
+		if (element == nullptr)
+			return false;
+		value = trim(toString(element->getTextContent()));
+		return true;
+	}
+
+	bool getInt(const xercesc::DOMElement* root, const std::string& path, int& value)
+	{
+		std::string text;
+		if (!getValue(root, path, text))
+			return false;
+		std::istringstream iss(text);
+		int parsed;
+		if (!(iss >> parsed))
+		{
+			std::cerr << "Warning: Invalid integer '" << text << "' for <" << path << ">. Using default." << std::endl;
+			return false;
+		}
+		value = parsed;
+		return true;
+	}
+
+	bool getDouble(const xercesc::DOMElement* root, const std::string& path, double& value)
+	{
+		std::string text;
+		if (!getValue(root, path, text))
+			return false;
+		std::istringstream iss(text);
+		double parsed;
+		if (!(iss >> parsed))
+		{
+			std::cerr << "Warning: Invalid number '" << text << "' for <" << path << ">. Using default." << std::endl;
+			return false;
+		}
+		value = parsed;
+		return true;
+	}
+
+	bool getBool(const xercesc::DOMElement* root, const std::string& path, bool& value)
+	{
+		std::string text;
+		if (!getValue(root, path, text))
+			return false;
+		text = toLower(text);
+		if (text == "true" || text == "1" || text == "on" || text == "yes")
+			value = true;
+		else if (text == "false" || text == "0" || text == "off" || text == "no")
+			value = false;
+		else
+		{
+			std::cerr << "Warning: Invalid boolean '" << text << "' for <" << path << ">. Using default." << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool getDoubles(const xercesc::DOMElement* root, const std::string& path, std::vector<double>& values)
+	{
+		std::string text;
+		if (!getValue(root, path, text))
+			return false;
+		std::istringstream iss(text);
+		std::vector<double> parsed;
+		double value;
+		while (iss >> value)
+			parsed.push_back(value);
+		if (!iss.eof())
+		{
+			std::cerr << "Warning: Invalid number list '" << text << "' for <" << path << ">. Ignored." << std::endl;
+			return false;
+		}
+		values = parsed;
+		return true;
+	}
+}
+
+EMGUDPConfig::EMGUDPConfig() : packetFormat(TEXT), receiveMode(SINGLE), batchSize(32), rcvBuf(0),
+	maxDatagram(65536), fragmentTimeout(0.01),
+	readPolicy(EMGSampleRing::LATEST), ringSize(64), pullDeadline(0.0), pullSpin(50), conditioning(false),
+	resampling(RESAMPLE_NONE), decimation(1), decimationTaps(0),
+	calibrationMode(CALIBRATION_RUNNING), calibrationMethod(EMGAmplitudeCalibrator::WINDOW_RMS),
+	calibrationWindow(200), calibrationPercentile(1.0), calibrationOutlierFactor(5.0), calibrationDuration(0.0),
+	recordFormat(RECORD_STO), source(SOURCE_UDP), replaySpeed(1.0), replayLoop(false),
+	shmName("/emg_udp_simulink"), shmCapacity(256), shmSpin(50),
+	telemetryIp("127.0.0.1"), telemetryPort(0), telemetryDecimation(10),
+	metricsPeriod(1.0), realtimePriority(0), realtimeLockMemory(false), busyPoll(0), spin(false),
+	fanInAlignment(EMGFanIn::SEQUENCE), fanInTolerance(0.00025), fanInStallPolicy(EMGFanIn::HOLD), fanInTimeout(0.01),
+	reorderWindow(0), reorderMaxDelay(0.005), reorderGapFill(EMGReorderBuffer::HOLD),
+	clockSync(false), clockWindow(20.0), mixingInputs(0)
+{
+}
+
+void EMGUDPConfig::read(const std::string& fileName)
+{
+	// Initialize/Terminate are reference counted, this does not disturb the Xerces instance of CEINMS-RT.
+	xercesc::XMLPlatformUtils::Initialize();
+	{
+		xercesc::XercesDOMParser parser;
+		parser.setValidationScheme(xercesc::XercesDOMParser::Val_Never);
+		parser.setDoNamespaces(false);
+		parser.setDoSchema(false);
+		parser.setLoadExternalDTD(false);
+
+		try
+		{
+			parser.parse(fileName.c_str());
+		}
+		catch (const xercesc::XMLException& e)
+		{
+			std::cerr << "Warning: Could not read EMG UDP options from '" << fileName << "': " << toString(e.getMessage()) << ". Using defaults." << std::endl;
+		}
+		catch (const xercesc::DOMException& e)
+		{
+			std::cerr << "Warning: Could not read EMG UDP options from '" << fileName << "': " << toString(e.getMessage()) << ". Using defaults." << std::endl;
+		}
+
+		const xercesc::DOMDocument* doc = parser.getDocument();
+		const xercesc::DOMElement* root = doc != nullptr ? doc->getDocumentElement() : nullptr;
+		if (root != nullptr)
+		{
+			std::string value;
+
+			if (getValue(root, "packetFormat", value))
+			{
+				value = toLower(value);
+				if (value == "binary")
+					packetFormat = BINARY;
+				else if (value == "auto")
+					packetFormat = AUTO;
+				else if (value == "text")
+					packetFormat = TEXT;
+				else
+					std::cerr << "Warning: Unknown packetFormat '" << value << "' in " << fileName << ". Using text." << std::endl;
+			}
+
+			if (getValue(root, "receiveMode", value))
+			{
+				value = toLower(value);
+				if (value == "batch")
+					receiveMode = BATCH;
+				else if (value == "single")
+					receiveMode = SINGLE;
+				else
+					std::cerr << "Warning: Unknown receiveMode '" << value << "' in " << fileName << ". Using single." << std::endl;
+			}
+			getInt(root, "batchSize", batchSize);
+			if (batchSize < 1)
+				batchSize = 1;
+			getInt(root, "rcvBuf", rcvBuf);
+			getInt(root, "maxDatagram", maxDatagram);
+			if (maxDatagram < 64 || maxDatagram > 65536)
+			{
+				std::cerr << "Warning: Invalid maxDatagram " << maxDatagram << " in " << fileName << ". Using 65536." << std::endl;
+				maxDatagram = 65536;
+			}
+			double fragmentMs;
+			if (getDouble(root, "fragments/timeout", fragmentMs) && fragmentMs > 0.0)
+				fragmentTimeout = fragmentMs * 1.0e-3;
+
+			if (getValue(root, "readPolicy", value))
+			{
+				value = toLower(value);
+				if (value == "latest")
+					readPolicy = EMGSampleRing::LATEST;
+				else if (value == "oldest")
+					readPolicy = EMGSampleRing::OLDEST_FIRST;
+				else if (value == "hold")
+					readPolicy = EMGSampleRing::HOLD_LAST;
+				else
+					std::cerr << "Warning: Unknown readPolicy '" << value << "' in " << fileName << ". Using latest." << std::endl;
+			}
+			getInt(root, "ringSize", ringSize);
+			if (ringSize < 2)
+				ringSize = 2;
+			double deadlineMs;
+			if (getDouble(root, "pull/deadline", deadlineMs))
+			{
+				if (deadlineMs < 0.0 || deadlineMs > 1000.0)
+					std::cerr << "Warning: Invalid pull deadline " << deadlineMs << " ms in " << fileName << ". GetDataMap() does not wait." << std::endl;
+				else
+					pullDeadline = deadlineMs * 1.0e-3;
+			}
+			getInt(root, "pull/spin", pullSpin);
+			if (pullSpin < 0)
+				pullSpin = 0;
+
+			getBool(root, "conditioning", conditioning);
+			getDoubles(root, "dcFilter/aCoeff", dcACoeff);
+			getDoubles(root, "dcFilter/bCoeff", dcBCoeff);
+			getDoubles(root, "hpFilter/aCoeff", hpACoeff);
+			getDoubles(root, "hpFilter/bCoeff", hpBCoeff);
+			getDoubles(root, "lpFilter/aCoeff", lpACoeff);
+			getDoubles(root, "lpFilter/bCoeff", lpBCoeff);
+
+			if (getValue(root, "resampling", value))
+			{
+				value = toLower(value);
+				if (value == "none")
+					resampling = RESAMPLE_NONE;
+				else if (value == "mean")
+					resampling = RESAMPLE_MEAN;
+				else if (value == "max")
+					resampling = RESAMPLE_MAX;
+				else if (value == "decimate")
+					resampling = RESAMPLE_DECIMATE;
+				else
+					std::cerr << "Warning: Unknown resampling '" << value << "' in " << fileName << ". Using none." << std::endl;
+			}
+			getInt(root, "decimation", decimation);
+			if (decimation < 1)
+				decimation = 1;
+			getInt(root, "decimationTaps", decimationTaps);
+			if (decimationTaps < 0)
+				decimationTaps = 0;
+
+			if (getValue(root, "calibration/mode", value))
+			{
+				value = toLower(value);
+				if (value == "running")
+					calibrationMode = CALIBRATION_RUNNING;
+				else if (value == "calibrate")
+					calibrationMode = CALIBRATION_CALIBRATE;
+				else if (value == "frozen")
+					calibrationMode = CALIBRATION_FROZEN;
+				else
+					std::cerr << "Warning: Unknown calibration mode '" << value << "' in " << fileName << ". Using running." << std::endl;
+			}
+			if (getValue(root, "calibration/method", value))
+			{
+				value = toLower(value);
+				if (value == "rms")
+					calibrationMethod = EMGAmplitudeCalibrator::WINDOW_RMS;
+				else if (value == "abs")
+					calibrationMethod = EMGAmplitudeCalibrator::ABSOLUTE;
+				else
+					std::cerr << "Warning: Unknown calibration method '" << value << "' in " << fileName << ". Using rms." << std::endl;
+			}
+			getInt(root, "calibration/window", calibrationWindow);
+			if (calibrationWindow < 1)
+				calibrationWindow = 1;
+			getDouble(root, "calibration/percentile", calibrationPercentile);
+			if (calibrationPercentile <= 0.0 || calibrationPercentile > 1.0)
+			{
+				std::cerr << "Warning: calibration percentile must be in ]0, 1]. Using 1." << std::endl;
+				calibrationPercentile = 1.0;
+			}
+			getDouble(root, "calibration/outlierFactor", calibrationOutlierFactor);
+			getDouble(root, "calibration/duration", calibrationDuration);
+			if (calibrationDuration < 0.0)
+				calibrationDuration = 0.0;
+
+			if (getValue(root, "recordFormat", value))
+			{
+				value = toLower(value);
+				if (value == "sto")
+					recordFormat = RECORD_STO;
+				else if (value == "binary")
+					recordFormat = RECORD_BINARY;
+				else
+					std::cerr << "Warning: Unknown record format '" << value << "' in " << fileName << ". Using sto." << std::endl;
+			}
+
+			if (getValue(root, "source", value))
+			{
+				value = toLower(value);
+				if (value == "udp")
+					source = SOURCE_UDP;
+				else if (value == "replay")
+					source = SOURCE_REPLAY;
+				else if (value == "shm")
+					source = SOURCE_SHM;
+				else
+					std::cerr << "Warning: Unknown source '" << value << "' in " << fileName << ". Using udp." << std::endl;
+			}
+			getValue(root, "replay/file", replayFile);
+			getDouble(root, "replay/speed", replaySpeed);
+			if (replaySpeed < 0.0)
+				replaySpeed = 0.0;
+			getBool(root, "replay/loop", replayLoop);
+			if (source == SOURCE_REPLAY && replayFile.empty())
+			{
+				std::cerr << "Warning: Replay source without <replay><file> in " << fileName << ". Using udp." << std::endl;
+				source = SOURCE_UDP;
+			}
+			getValue(root, "shm/name", shmName);
+			if (shmName.empty())
+				shmName = "/emg_udp_simulink";
+			else if (shmName[0] != '/')
+				shmName = "/" + shmName;
+			getInt(root, "shm/capacity", shmCapacity);
+			if (shmCapacity < 2 || shmCapacity > 65536)
+			{
+				std::cerr << "Warning: Invalid shm capacity " << shmCapacity << " in " << fileName << ". Using 256." << std::endl;
+				shmCapacity = 256;
+			}
+			getInt(root, "shm/spin", shmSpin);
+			if (shmSpin < 0)
+				shmSpin = 0;
+
+			getBool(root, "clock/sync", clockSync);
+			getDouble(root, "clock/window", clockWindow);
+			if (clockWindow <= 0.0)
+			{
+				std::cerr << "Warning: Invalid clock window " << clockWindow << " in " << fileName << ". Using 20 s." << std::endl;
+				clockWindow = 20.0;
+			}
+
+			// Linear mixing of the received channels, rows from a file and/or inline
+			getInt(root, "mixing/inputs", mixingInputs);
+			if (mixingInputs < 0 || mixingInputs > 4096)
+			{
+				std::cerr << "Warning: Invalid mixing inputs " << mixingInputs << " in " << fileName << ". Mixing disabled." << std::endl;
+				mixingInputs = 0;
+			}
+			getValue(root, "mixing/file", mixingFile);
+			const xercesc::DOMElement* mixingElement = findElement(root, "mixing");
+			if (mixingElement != nullptr)
+			{
+				mixingRows.clear();
+				for (const xercesc::DOMElement* child = mixingElement->getFirstElementChild(); child != nullptr; child = child->getNextElementSibling())
+				{
+					if (toString(child->getTagName()) != "row")
+						continue;
+					MixingRow row;
+					getValue(child, "channel", row.channel);
+					getValue(child, "weights", row.weights);
+					if (row.channel.empty())
+					{
+						std::cerr << "Warning: <mixing><row> without <channel> in " << fileName << ". Ignored." << std::endl;
+						continue;
+					}
+					mixingRows.push_back(row);
+				}
+			}
+			if (mixingInputs == 0 && (!mixingFile.empty() || !mixingRows.empty()))
+				std::cerr << "Warning: Mixing matrix without <mixing><inputs> in " << fileName << ". Mixing disabled." << std::endl;
+
+			getValue(root, "telemetry/ip", telemetryIp);
+			getInt(root, "telemetry/port", telemetryPort);
+			if (telemetryPort < 0 || telemetryPort > 65535)
+			{
+				std::cerr << "Warning: Invalid telemetry port " << telemetryPort << " in " << fileName << ". Telemetry disabled." << std::endl;
+				telemetryPort = 0;
+			}
+			getInt(root, "telemetry/decimation", telemetryDecimation);
+			if (telemetryDecimation < 1)
+				telemetryDecimation = 1;
+
+			getValue(root, "metrics/file", metricsFile);
+			getDouble(root, "metrics/period", metricsPeriod);
+			if (metricsPeriod <= 0.0)
+				metricsPeriod = 1.0;
+
+			std::vector<double> cpus;
+			if (getDoubles(root, "realtime/cpu", cpus))
+			{
+				realtimeCpus.clear();
+				for (double cpu : cpus)
+					realtimeCpus.push_back(static_cast<int>(cpu));
+			}
+			getInt(root, "realtime/priority", realtimePriority);
+			if (realtimePriority < 0 || realtimePriority > 99)
+			{
+				std::cerr << "Warning: realtime priority must be in [0, 99]. Using 0 (default scheduler)." << std::endl;
+				realtimePriority = 0;
+			}
+			getBool(root, "realtime/lockMemory", realtimeLockMemory);
+			getInt(root, "realtime/busyPoll", busyPoll);
+			if (busyPoll < 0)
+				busyPoll = 0;
+			getBool(root, "realtime/spin", spin);
+
+			// Several senders, each one with a subset of the channels
+			const xercesc::DOMElement* endpointsElement = findElement(root, "endpoints");
+			if (endpointsElement != nullptr)
+			{
+				endpoints.clear();
+				for (const xercesc::DOMElement* child = endpointsElement->getFirstElementChild(); child != nullptr; child = child->getNextElementSibling())
+				{
+					if (toString(child->getTagName()) != "endpoint")
+						continue;
+					Endpoint endpoint;
+					endpoint.port = 0;
+					getValue(child, "ip", endpoint.ip);
+					getInt(child, "port", endpoint.port);
+					std::string channelList;
+					getValue(child, "channels", channelList);
+					std::istringstream iss(channelList);
+					std::string channel;
+					while (iss >> channel)
+						endpoint.channels.push_back(channel);
+					if (endpoint.port <= 0 || endpoint.channels.empty())
+					{
+						std::cerr << "Warning: <endpoint> without <port> or <channels> in " << fileName << ". Ignored." << std::endl;
+						continue;
+					}
+					endpoints.push_back(endpoint);
+				}
+				if (endpoints.size() > 32)
+				{
+					std::cerr << "Warning: At most 32 endpoints in " << fileName << ". The others are ignored." << std::endl;
+					endpoints.resize(32);
+				}
+			}
+			if (getValue(root, "fanIn/alignment", value))
+			{
+				value = toLower(value);
+				if (value == "sequence")
+					fanInAlignment = EMGFanIn::SEQUENCE;
+				else if (value == "time")
+					fanInAlignment = EMGFanIn::SENDER_TIME;
+				else
+					std::cerr << "Warning: Unknown fanIn alignment '" << value << "' in " << fileName << ". Using sequence." << std::endl;
+			}
+			double milliseconds;
+			if (getDouble(root, "fanIn/tolerance", milliseconds) && milliseconds >= 0.0)
+				fanInTolerance = milliseconds * 1.0e-3;
+			if (getValue(root, "fanIn/stallPolicy", value))
+			{
+				value = toLower(value);
+				if (value == "hold")
+					fanInStallPolicy = EMGFanIn::HOLD;
+				else if (value == "zero")
+					fanInStallPolicy = EMGFanIn::ZERO;
+				else if (value == "drop")
+					fanInStallPolicy = EMGFanIn::DROP;
+				else
+					std::cerr << "Warning: Unknown fanIn stall policy '" << value << "' in " << fileName << ". Using hold." << std::endl;
+			}
+			if (getDouble(root, "fanIn/stallTimeout", milliseconds) && milliseconds >= 0.0)
+				fanInTimeout = milliseconds * 1.0e-3;
+			getInt(root, "reorder/window", reorderWindow);
+			if (reorderWindow < 0 || reorderWindow > 1024)
+			{
+				std::cerr << "Warning: Invalid reorder window in " << fileName << ". Reorder buffer disabled." << std::endl;
+				reorderWindow = 0;
+			}
+			if (getDouble(root, "reorder/maxDelay", milliseconds) && milliseconds >= 0.0)
+				reorderMaxDelay = milliseconds * 1.0e-3;
+			if (getValue(root, "reorder/gapFill", value))
+			{
+				value = toLower(value);
+				if (value == "hold")
+					reorderGapFill = EMGReorderBuffer::HOLD;
+				else if (value == "linear")
+					reorderGapFill = EMGReorderBuffer::INTERPOLATE;
+				else if (value == "nan")
+					reorderGapFill = EMGReorderBuffer::NAN_MARK;
+				else
+					std::cerr << "Warning: Unknown reorder gap fill '" << value << "' in " << fileName << ". Using hold." << std::endl;
+			}
+		}
+	}
+	xercesc::XMLPlatformUtils::Terminate();
+}
+
+void EMGUDPConfig::print() const
+{
+	static const char* formatNames[] = { "text", "binary", "auto" };
+	std::cout << "EMG_UDP_Simulink: Packet format: " << formatNames[packetFormat] << ", datagrams up to " << maxDatagram
+		<< " bytes, fragment timeout " << fragmentTimeout * 1.0e3 << " ms" << std::endl;
+	if (receiveMode == BATCH)
+		std::cout << "EMG_UDP_Simulink: Receive mode: batch (" << batchSize << " datagrams per call, kernel time stamps)" << std::endl;
+	else
+		std::cout << "EMG_UDP_Simulink: Receive mode: single" << std::endl;
+	static const char* policyNames[] = { "latest", "oldest", "hold" };
+	std::cout << "EMG_UDP_Simulink: Read policy: " << policyNames[readPolicy] << ", ring of " << ringSize << " samples" << std::endl;
+	if (pullDeadline > 0.0)
+		std::cout << "EMG_UDP_Simulink: Pull mode: GetDataMap() waits up to " << pullDeadline * 1.0e3 << " ms for a new sample, futex wait after "
+			<< pullSpin << " us of polling" << std::endl;
+	if (conditioning)
+		std::cout << "EMG_UDP_Simulink: Conditioning: dc " << (dcBCoeff.empty() ? "off" : "on") << ", high-pass " << (hpBCoeff.empty() ? "off" : "on")
+			<< ", rectification, low-pass " << (lpBCoeff.empty() ? "off" : "on") << std::endl;
+	static const char* calibrationNames[] = { "running max", "calibrate", "frozen" };
+	std::cout << "EMG_UDP_Simulink: Calibration: " << calibrationNames[calibrationMode];
+	if (calibrationMode == CALIBRATION_CALIBRATE)
+		std::cout << " (" << (calibrationMethod == EMGAmplitudeCalibrator::WINDOW_RMS ? "window RMS" : "|x|")
+			<< ", window " << calibrationWindow << ", percentile " << calibrationPercentile << ", outlier factor " << calibrationOutlierFactor << ")";
+	if (calibrationMode != CALIBRATION_RUNNING && calibrationDuration > 0.0)
+		std::cout << ", frozen after " << calibrationDuration << " s of calibration";
+	std::cout << std::endl;
+	static const char* resamplingNames[] = { "none", "mean", "max", "decimate" };
+	std::cout << "EMG_UDP_Simulink: Resampling: " << resamplingNames[resampling];
+	if (resampling == RESAMPLE_DECIMATE)
+		std::cout << " by " << decimation;
+	std::cout << std::endl;
+	if (source == SOURCE_REPLAY)
+	{
+		std::cout << "EMG_UDP_Simulink: Source: replay of " << replayFile << ", ";
+		if (replaySpeed > 0.0)
+			std::cout << replaySpeed << "x speed";
+		else
+			std::cout << "as fast as possible";
+		std::cout << (replayLoop ? ", loop" : "") << std::endl;
+	}
+	if (source == SOURCE_SHM)
+		std::cout << "EMG_UDP_Simulink: Source: shared memory " << shmName << ", " << shmCapacity << " samples, "
+			<< (spin ? "spin" : "futex wait after " + std::to_string(shmSpin) + " us of polling") << std::endl;
+	if (!realtimeCpus.empty() || realtimePriority > 0 || realtimeLockMemory || busyPoll > 0 || spin)
+	{
+		std::cout << "EMG_UDP_Simulink: Real-time:";
+		if (!realtimeCpus.empty())
+		{
+			std::cout << " CPU";
+			for (int cpu : realtimeCpus)
+				std::cout << " " << cpu;
+			std::cout << ",";
+		}
+		if (realtimePriority > 0)
+			std::cout << " SCHED_FIFO " << realtimePriority << ",";
+		if (realtimeLockMemory)
+			std::cout << " locked memory,";
+		if (busyPoll > 0)
+			std::cout << " SO_BUSY_POLL " << busyPoll << " us,";
+		std::cout << (spin ? " spin" : " epoll wait") << std::endl;
+	}
+	for (const Endpoint& endpoint : endpoints)
+	{
+		std::cout << "EMG_UDP_Simulink: Endpoint " << (endpoint.ip.empty() ? "<ip>" : endpoint.ip) << ":" << endpoint.port << ":";
+		for (const std::string& channel : endpoint.channels)
+			std::cout << " " << channel;
+		std::cout << std::endl;
+	}
+	if (!endpoints.empty())
+	{
+		static const char* policyNames[] = { "hold", "zero", "drop" };
+		std::cout << "EMG_UDP_Simulink: Fan-in by " << (fanInAlignment == EMGFanIn::SEQUENCE ? "sequence" : "sender time")
+			<< ", stall policy " << policyNames[fanInStallPolicy] << " after " << fanInTimeout * 1.0e3 << " ms" << std::endl;
+	}
+	if (reorderWindow > 0)
+	{
+		static const char* gapFillNames[] = { "hold", "linear", "nan" };
+		std::cout << "EMG_UDP_Simulink: Reorder window " << reorderWindow << " samples, max delay " << reorderMaxDelay * 1.0e3
+			<< " ms, gap fill " << gapFillNames[reorderGapFill] << std::endl;
+	}
+	if (mixingInputs > 0)
+		std::cout << "EMG_UDP_Simulink: Mixing of " << mixingInputs << " received channels"
+			<< (mixingFile.empty() ? "" : ", matrix " + mixingFile) << ", " << mixingRows.size() << " rows in the XML" << std::endl;
+	if (clockSync)
+		std::cout << "EMG_UDP_Simulink: Sender clock mapped to the host clock, fit over " << clockWindow << " s" << std::endl;
+	if (telemetryPort > 0)
+		std::cout << "EMG_UDP_Simulink: Telemetry to " << telemetryIp << ":" << telemetryPort << ", one sample out of " << telemetryDecimation << std::endl;
+	if (!metricsFile.empty())
+		std::cout << "EMG_UDP_Simulink: Metrics: " << metricsFile << " every " << metricsPeriod << " s" << std::endl;
+	std::cout << "EMG_UDP_Simulink: Record format: " << (recordFormat == RECORD_BINARY ? "binary (.emgrec)" : "sto") << std::endl;
+}
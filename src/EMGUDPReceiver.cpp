@@ -0,0 +1,112 @@
+#include "EMGUDPReceiver.h"
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+
+#include <getTime.h>
+
+namespace
+{
+	inline double toSeconds(const struct timespec& ts)
+	{
+		return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+	}
+
+	// Offset between the kernel timestamp clock (CLOCK_REALTIME) and rtb::getTime()
+	inline double realtimeOffset()
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_REALTIME, &now);
+		return rtb::getTime() - toSeconds(now);
+	}
+}
+
+EMGUDPReceiver::EMGUDPReceiver(size_t batchSize, size_t bufferSize) :
+	batchSize_(batchSize > 0 ? batchSize : 1), bufferSize_(bufferSize), timestamps_(false),
+	buffers_(batchSize_ * bufferSize_), iovecs_(batchSize_), addresses_(batchSize_),
+#if defined(__linux__)
+	messages_(batchSize_),
+#endif
+	datagrams_(batchSize_)
+{
+	controlSize_ = CMSG_SPACE(sizeof(struct timespec));
+	control_.resize(batchSize_ * controlSize_);
+	for (size_t i = 0; i < batchSize_; ++i)
+	{
+		iovecs_[i].iov_base = &buffers_[i * bufferSize_];
+		iovecs_[i].iov_len = bufferSize_ - 1; // -1 for the null terminator
+		datagrams_[i].data = &buffers_[i * bufferSize_];
+		datagrams_[i].size = 0;
+		datagrams_[i].time = 0.0;
+		datagrams_[i].truncated = false;
+	}
+}
+
+bool EMGUDPReceiver::enableTimestamps(int sockFd)
+{
+#if defined(SO_TIMESTAMPNS)
+	int enable = 1;
+	timestamps_ = setsockopt(sockFd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0;
+#else
+	timestamps_ = false;
+#endif
+	return timestamps_;
+}
+
+int EMGUDPReceiver::receive(int sockFd)
+{
+#if defined(__linux__)
+	for (size_t i = 0; i < batchSize_; ++i)
+	{
+		struct msghdr& hdr = messages_[i].msg_hdr;
+		hdr.msg_name = &addresses_[i];
+		hdr.msg_namelen = sizeof(struct sockaddr_in);
+		hdr.msg_iov = &iovecs_[i];
+		hdr.msg_iovlen = 1;
+		hdr.msg_control = timestamps_ ? &control_[i * controlSize_] : nullptr;
+		hdr.msg_controllen = timestamps_ ? controlSize_ : 0;
+		hdr.msg_flags = 0;
+		messages_[i].msg_len = 0;
+	}
+
+	// MSG_WAITFORONE: block (blocking socket only) for the first datagram, then take what is queued
+	// MSG_TRUNC: msg_len is the size on the wire of a datagram larger than its buffer
+	int nbReceived = recvmmsg(sockFd, messages_.data(), batchSize_, MSG_WAITFORONE | MSG_TRUNC, nullptr);
+	if (nbReceived <= 0)
+		return nbReceived;
+
+	const double offset = realtimeOffset();
+	const double wakeupTime = rtb::getTime();
+	for (int i = 0; i < nbReceived; ++i)
+	{
+		Datagram& datagram = datagrams_[i];
+		datagram.size = messages_[i].msg_len;
+		datagram.truncated = (messages_[i].msg_hdr.msg_flags & MSG_TRUNC) != 0 || datagram.size > bufferSize_ - 1;
+		buffers_[i * bufferSize_ + std::min(datagram.size, bufferSize_ - 1)] = '\0';
+		datagram.time = wakeupTime;
+
+		struct msghdr& hdr = messages_[i].msg_hdr;
+		for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+			{
+				struct timespec ts;
+				std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+				datagram.time = toSeconds(ts) + offset;
+			}
+		}
+	}
+	return nbReceived;
+#else
+	socklen_t addressSize = sizeof(struct sockaddr_in);
+	int bytesRead = recvfrom(sockFd, &buffers_[0], bufferSize_ - 1, MSG_TRUNC, (struct sockaddr*)&addresses_[0], &addressSize);
+	if (bytesRead < 0)
+		return -1;
+	datagrams_[0].size = bytesRead;
+	datagrams_[0].truncated = static_cast<size_t>(bytesRead) > bufferSize_ - 1;
+	buffers_[std::min(datagrams_[0].size, bufferSize_ - 1)] = '\0';
+	datagrams_[0].time = rtb::getTime();
+	return 1;
+#endif
+}
@@ -4,25 +4,30 @@
 #include <mutex>
 #include <thread>
 #include <cmath>
+#include <limits>
 #include <iostream> // For std::cout, std::cerr
 #include <map>
-#include <algorithm> // For std::fill, std::replace
+#include <algorithm> // For std::fill
 #include <stdexcept> // For std::runtime_error
 #include <string>    // For std::string
 #include <vector>    // For std::vector
 #include <fstream>   // For std::ifstream
 #include <cstdio>    // For remove()
-#include <sstream>   // NEW: For std::istringstream
 
 // Unix-specific includes
 #include <errno.h>   // For errno and strerror
 #include <cstring>   // For strtok (not used in new parsing), memset, strcpy
+#include <fcntl.h>   // For O_NONBLOCK
 
 
 // CEINMS-RT specific includes
 #include <getTime.h>         // Custom time utility
 #include <ExecutionXmlReader.h> // For reading CEINMS configuration
 
+#include "EMGBinaryPacket.h"
+#include "EMGTextParser.h"
+#include "EMGUDPReceiver.h"
+
 
 
 // Constructor initializes members
@@ -31,7 +36,14 @@ EMGUDPSimulink::EMGUDPSimulink() : emgSockFd(-1), _logger(nullptr), _executionEm
 	_record = false;
 	_connect = false;
     threadEnd_ = false; // Initialize to false
-    newData_ = false;   // Initialize to false
+    sampleSequence_ = 0;
+    sampleView_ = EMGSampleView(); // Empty until init()
+    calibrating_ = false;
+    calibrationReset_ = false;
+    calibrationStart_ = 0.0;
+    std::fill(binaryErrors_, binaryErrors_ + EMGBinaryPacket::BAD_FRAGMENT + 1, 0);
+    metricsEnd_ = false;
+    kernels_ = EMGKernels::select(0); // Generic until init() knows the channel count
     timenow_ = 0.0;     // Initialize time
     
     // maxAmp_ will be initialized in init()
@@ -56,12 +68,11 @@ void EMGUDPSimulink::init(std::string xmlName, std::string executionName)
 	ip_ = "127.0.0.1";
 	port_ = 31000;
 
-	// Initialize logger if recording is enabled
+	// Check the output directory if recording is enabled, the logger is created once the record format is known
 	if (_record) {
 		if (_outDirectory.empty()) {
             throw std::runtime_error("Output directory not set for logging in EMG plugin. It is critical for logging.");
         }
-		_logger = new OpenSimFileLogger<int>(_outDirectory);
 	}
 
 	// Parse Subject XML
@@ -100,6 +111,10 @@ void EMGUDPSimulink::init(std::string xmlName, std::string executionName)
 	ip_ = _executionEmgXml->getIP();
 	port_ = atoi(_executionEmgXml->getPort().c_str());
 
+	// Plugin specific options (packet format, ...) from the same file
+	config_.read(EMGFile);
+	config_.print();
+
     // --- NEW: Read initial maxAmp_ values from ExecutionEmgXml ---
     // Assuming ExecutionEmgXml has a public const std::vector<double>& getMaxEmg() const method
     try {
@@ -140,62 +155,304 @@ void EMGUDPSimulink::init(std::string xmlName, std::string executionName)
 	// Add log for EMG if recording
 	if (_record)
 	{
-		_logger->addLog(Logger::EmgsFilter, nameVect_);
+		if (config_.recordFormat == EMGUDPConfig::RECORD_BINARY)
+		{
+			recorder_.reset(new EMGRecorder());
+			recordSample_.assign(2 * nameVect_.size(), 0.0);
+			if (!recorder_->start(_outDirectory + "/emg.emgrec", nameVect_))
+				throw std::runtime_error("Cannot create the EMG recording " + _outDirectory + "/emg.emgrec");
+		}
+		else
+		{
+			_logger = new OpenSimFileLogger<int>(_outDirectory);
+			_logger->addLog(Logger::EmgsFilter, nameVect_);
+		}
+	}
+
+	// In-plugin conditioning of raw EMG with the filters of executionEMG.xml
+	if (config_.conditioning)
+	{
+		if (!conditioner_.setup(config_.dcACoeff, config_.dcBCoeff, config_.hpACoeff, config_.hpBCoeff,
+			config_.lpACoeff, config_.lpBCoeff, nameVect_.size()))
+		{
+			throw std::runtime_error("Invalid filter coefficients in " + EMGFile + ": at most 2 aCoeff and 3 bCoeff per filter.");
+		}
+		if (std::fabs(conditioner_.getDCGain()) > EMGConditioner::MAX_DC_GAIN)
+		{
+			std::cerr << "Warning: dcFilter of " << EMGFile << " has a DC gain of " << conditioner_.getDCGain()
+				<< " instead of 0, the offset is only removed by hpFilter." << std::endl;
+		}
 	}
 
+	// Rate conversion between the sender and the model
+	decimator_.setup(config_.decimation, config_.decimationTaps, nameVect_.size());
+	decimatedEMGdata_.assign(nameVect_.size(), 0.0);
+	windowReducer_.setup(config_.resampling == EMGUDPConfig::RESAMPLE_MAX ? EMGWindowReducer::MAX : EMGWindowReducer::MEAN, nameVect_.size());
+	windowSample_.assign(nameVect_.size(), 0.0);
+
+	// Robust MVC estimation instead of the running max
+	calibrator_.setup(config_.calibrationMethod, config_.calibrationWindow, config_.calibrationPercentile,
+		config_.calibrationOutlierFactor, nameVect_.size());
+	calibrating_ = config_.calibrationMode == EMGUDPConfig::CALIBRATION_CALIBRATE;
+	calibrationStart_ = std::numeric_limits<double>::quiet_NaN();
+
+	// Max tracking and normalization kernels for this channel count
+	kernels_ = EMGKernels::select(nameVect_.size());
+
+	// Sender clock to host clock, a replay keeps its recorded time stamps
+	clockSync_.setup(config_.clockSync && config_.source != EMGUDPConfig::SOURCE_REPLAY ? config_.clockWindow : 0.0);
+
 	threadEnd_ = true; // Set flag to allow thread to run
-    newData_ = false;   // No new data yet
+
+	// Hand-off between the feeder thread and GetDataMap(), no new data yet
+	sampleRing_.reset(new EMGSampleRing(config_.ringSize, nameVect_.size()));
+	if (config_.pullDeadline > 0.0)
+		sampleRing_->enableWakeup();
+	// Only the newest sample is read: a consumer pause must not leave the ring full of old ones.
+	// oldest and mean/max read every sample, a loss there stays an overrun.
+	if (config_.readPolicy != EMGSampleRing::OLDEST_FIRST && config_.resampling != EMGUDPConfig::RESAMPLE_MEAN &&
+		config_.resampling != EMGUDPConfig::RESAMPLE_MAX)
+		sampleRing_->enableOverwrite();
+
+	// Processed samples for a monitor, sent by a background thread
+	if (config_.telemetryPort > 0 && !telemetry_.start(config_.telemetryIp, config_.telemetryPort, nameVect_.size(), config_.telemetryDecimation))
+		std::cerr << "Warning: Cannot send EMG telemetry to " << config_.telemetryIp << ":" << config_.telemetryPort << ". Telemetry disabled." << std::endl;
+	dataEMGSafe_.assign(nameVect_.size(), 0.0);
+	sampleView_.data = dataEMGSafe_.data();
+	sampleView_.size = dataEMGSafe_.size();
+	sampleView_.time = 0.0;
+	sampleView_.sequence = 0;
+	sampleView_.fresh = false;
+
+	// The map nodes are created once, GetDataMap() then writes through pointers in channel order
+	mapValues_.clear();
+	for (const auto& name : nameVect_)
+	{
+		mapData_[name] = 0.0;
+		mapValues_.push_back(&mapData_[name]);
+	}
+
+	// Packets put back in sender order, the gaps they leave filled
+	if (config_.reorderWindow > 0)
+		reorder_.setup(nameVect_.size(), config_.reorderWindow, config_.reorderMaxDelay, config_.reorderGapFill);
+	reorderSample_.assign(nameVect_.size(), 0.0);
+	receiveSample_.assign(nameVect_.size(), 0.0);
+
+	// Received channels mixed into the channels of the subject XML
+	mixer_.setup(0, 0);
+	if (config_.mixingInputs > 0)
+	{
+		if (config_.source == EMGUDPConfig::SOURCE_REPLAY || !config_.endpoints.empty())
+			std::cerr << "Warning: <mixing> applies to a single udp or shm source, a replay is already mixed. Mixing disabled." << std::endl;
+		else
+			setupMixer();
+	}
+	const size_t nbInput = mixer_.isEnabled() ? mixer_.getNbInput() : nameVect_.size();
+	mixerInput_.assign(nbInput, 0.0);
+
+	// Datagrams up to <maxDatagram>, frames of several datagrams reassembled
+	datagramBuffer_.assign(config_.maxDatagram + 1, '\0');
+	frameAssembler_.setup(nbInput, 16, config_.fragmentTimeout);
+
+	// Periodic metrics summary
+	metricsEnd_ = false;
+	if (!config_.metricsFile.empty())
+		metricsThread_ = std::make_shared<std::thread>(&EMGUDPSimulink::metricsReport, this);
+
+	// Replay a recorded session instead of listening to the sender
+	if (config_.source == EMGUDPConfig::SOURCE_REPLAY)
+	{
+		if (!replaySource_.open(config_.replayFile, nameVect_))
+			throw std::runtime_error("Cannot replay " + config_.replayFile + ": file unreadable or channels of the subject XML missing.");
+		replaySource_.setPacing(config_.replaySpeed, config_.replayLoop);
+		feederThread = std::make_shared<std::thread>(&EMGUDPSimulink::replayFeed, this);
+		return;
+	}
+
+	// Local producer writing the shared memory ring, no socket
+	if (config_.source == EMGUDPConfig::SOURCE_SHM)
+	{
+		if (!shmTransport_.create(config_.shmName, nbInput, config_.shmCapacity))
+			throw std::runtime_error("Failed to create the EMG shared memory ring " + config_.shmName + ": " + std::string(strerror(errno)));
+		std::cout << "EMG_UDP_Simulink: Shared memory ring " << config_.shmName << " ready" << std::endl;
+		feederThread = std::make_shared<std::thread>(&EMGUDPSimulink::shmFeed, this);
+		return;
+	}
+
+	// Several senders, each one with a subset of the channels, merged into one frame
+	if (!config_.endpoints.empty())
+	{
+		std::vector<std::vector<size_t>> endpointChannels;
+		std::vector<bool> covered(nameVect_.size(), false);
+		for (const EMGUDPConfig::Endpoint& endpoint : config_.endpoints)
+		{
+			std::vector<size_t> indices;
+			for (const std::string& channel : endpoint.channels)
+			{
+				const size_t index = std::find(nameVect_.begin(), nameVect_.end(), channel) - nameVect_.begin();
+				if (index == nameVect_.size())
+					throw std::runtime_error("Endpoint channel " + channel + " is not in the subject XML.");
+				indices.push_back(index);
+				covered[index] = true;
+			}
+			endpointChannels.push_back(indices);
+			endpointData_.push_back(std::vector<double>(indices.size(), 0.0));
+			endpointPackets_.push_back(0);
+			endpointFds_.push_back(openSocket(endpoint.ip.empty() ? ip_ : endpoint.ip, endpoint.port));
+		}
+		for (size_t i = 0; i < nameVect_.size(); ++i)
+			if (!covered[i])
+				std::cerr << "Warning: EMG channel " << nameVect_[i] << " is sent by no endpoint, it stays at 0." << std::endl;
+
+		fanIn_.setup(endpointChannels, nameVect_.size(), config_.fanInAlignment, config_.fanInTolerance,
+			config_.fanInStallPolicy, config_.fanInTimeout);
+		fanInFrame_.assign(nameVect_.size(), 0.0);
+		if (!config_.spin)
+		{
+			bool ok = socketWaiter_.open(endpointFds_[0]);
+			for (size_t i = 1; i < endpointFds_.size(); ++i)
+				ok = ok && socketWaiter_.add(endpointFds_[i]);
+			if (!ok)
+				throw std::runtime_error("Failed to create the epoll wait of the EMG UDP sockets: " + std::string(strerror(errno)));
+		}
+		feederThread = std::make_shared<std::thread>(&EMGUDPSimulink::fanInFeed, this);
+		return;
+	}
 
     // --- UDP Socket Setup (Unix specific) ---
-    emgSockFd = socket(AF_INET, SOCK_DGRAM, 0); // Create IPv4 UDP socket
-    if (emgSockFd < 0) {
+    emgSockFd = openSocket(ip_, port_);
+    if (!config_.spin && !socketWaiter_.open(emgSockFd)) {
+        close(emgSockFd);
+        throw std::runtime_error("Failed to create the epoll wait of the EMG UDP socket: " + std::string(strerror(errno)));
+    }
+
+    if (config_.receiveMode == EMGUDPConfig::BATCH) {
+        receiver_.reset(new EMGUDPReceiver(config_.batchSize, config_.maxDatagram + 1));
+        if (!receiver_->enableTimestamps(emgSockFd)) {
+            std::cerr << "Warning: setsockopt(SO_TIMESTAMPNS) failed for EMG socket, using wakeup time as receive time." << std::endl;
+        }
+    }
+
+    // Start the background thread for EMG data reception and processing
+	feederThread = std::make_shared<std::thread>(&EMGUDPSimulink::EMGFeed, this);
+}
+
+void EMGUDPSimulink::setupMixer()
+{
+	std::string error;
+	mixer_.setup(config_.mixingInputs, nameVect_.size());
+	if (!config_.mixingFile.empty() && !mixer_.load(config_.mixingFile, nameVect_, error))
+		throw std::runtime_error("Invalid EMG mixing matrix: " + error);
+	for (const EMGUDPConfig::MixingRow& row : config_.mixingRows)
+	{
+		const size_t output = std::find(nameVect_.begin(), nameVect_.end(), row.channel) - nameVect_.begin();
+		if (output == nameVect_.size())
+			throw std::runtime_error("Mixing channel " + row.channel + " is not in the subject XML.");
+		if (!mixer_.setRow(output, row.weights, error))
+			throw std::runtime_error("Invalid EMG mixing weights of " + row.channel + ": " + error);
+	}
+	for (size_t i = 0; i < nameVect_.size(); ++i)
+		if (mixer_.getRowNonZeros(i) == 0)
+			std::cerr << "Warning: EMG channel " << nameVect_[i] << " has no mixing weight, it stays at 0." << std::endl;
+	mixer_.prepare();
+	std::cout << "EMG_UDP_Simulink: Mixing " << mixer_.getNbInput() << " received channels into " << mixer_.getNbOutput()
+		<< ", " << mixer_.getNonZeros() << " weights, " << (mixer_.isSparse() ? "sparse" : "dense") << " product" << std::endl;
+}
+
+int EMGUDPSimulink::openSocket(const std::string& ip, int port)
+{
+    int sockFd = socket(AF_INET, SOCK_DGRAM, 0); // Create IPv4 UDP socket
+    if (sockFd < 0) {
         throw std::runtime_error("Failed to create EMG UDP socket: " + std::string(strerror(errno)));
     }
-    std::cout << "EMG_UDP_Simulink: UDP Socket created with FD: " << emgSockFd << std::endl;
+    std::cout << "EMG_UDP_Simulink: UDP Socket created with FD: " << sockFd << std::endl;
 
     // Allow reuse of address/port (useful for quick restarts during development)
     int reuse = 1;
-    if (setsockopt(emgSockFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+    if (setsockopt(sockFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
         std::cerr << "Warning: setsockopt(SO_REUSEADDR) failed for EMG socket: " << strerror(errno) << std::endl;
     }
-    if (setsockopt(emgSockFd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
+    if (setsockopt(sockFd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
         std::cerr << "Warning: setsockopt(SO_REUSEPORT) failed for EMG socket: " << strerror(errno) << std::endl;
     }
 
     struct sockaddr_in serverInfo;
     memset(&serverInfo, 0, sizeof(serverInfo)); // Clear the structure
     serverInfo.sin_family = AF_INET;           // IPv4
-    serverInfo.sin_port = htons(port_);        // Port to listen on (network byte order)
+    serverInfo.sin_port = htons(port);        // Port to listen on (network byte order)
     
     // Convert IP string to binary form (for specific IP binding, e.g., "127.0.0.1")
-    if (inet_pton(AF_INET, ip_.c_str(), &(serverInfo.sin_addr)) <= 0) {
-        close(emgSockFd);
-        throw std::runtime_error("Invalid IP address for EMG socket: " + ip_);
+    if (inet_pton(AF_INET, ip.c_str(), &(serverInfo.sin_addr)) <= 0) {
+        close(sockFd);
+        throw std::runtime_error("Invalid IP address for EMG socket: " + ip);
     }
 
     // Bind the socket to the specified IP and port
-    if (::bind(emgSockFd, (const struct sockaddr*)&serverInfo, sizeof(serverInfo)) < 0) {
-        close(emgSockFd);
-        throw std::runtime_error("Failed to bind EMG UDP socket to " + ip_ + ":" + std::to_string(port_) + ": " + strerror(errno));
+    if (::bind(sockFd, (const struct sockaddr*)&serverInfo, sizeof(serverInfo)) < 0) {
+        close(sockFd);
+        throw std::runtime_error("Failed to bind EMG UDP socket to " + ip + ":" + std::to_string(port) + ": " + strerror(errno));
     }
-    std::cout << "EMG_UDP_Simulink: UDP Socket bound to " << ip_ << ":" << port_ << std::endl;
+    std::cout << "EMG_UDP_Simulink: UDP Socket bound to " << ip << ":" << port << std::endl;
 
-    // Start the background thread for EMG data reception and processing
-	feederThread = std::make_shared<std::thread>(&EMGUDPSimulink::EMGFeed, this);
+    // Larger kernel receive buffer to absorb sender bursts (capped by net.core.rmem_max)
+    if (config_.rcvBuf > 0) {
+        int rcvBuf = config_.rcvBuf;
+        if (setsockopt(sockFd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf)) < 0) {
+            std::cerr << "Warning: setsockopt(SO_RCVBUF) failed for EMG socket: " << strerror(errno) << std::endl;
+        }
+        socklen_t optLen = sizeof(rcvBuf);
+        if (getsockopt(sockFd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, &optLen) == 0) {
+            std::cout << "EMG_UDP_Simulink: Socket receive buffer: " << rcvBuf << " bytes" << std::endl;
+        }
+    }
+
+    // Kernel busy polling of the device queue on receive, needs CAP_NET_ADMIN above net.core.busy_read
+    if (config_.busyPoll > 0) {
+        int busyPoll = config_.busyPoll;
+        if (setsockopt(sockFd, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll)) < 0) {
+            std::cerr << "Warning: setsockopt(SO_BUSY_POLL) failed for EMG socket: " << strerror(errno) << std::endl;
+        }
+    }
+
+    // Non-blocking socket: the feeder thread waits in epoll, or spins, and stop() wakes it up through an eventfd
+    if (fcntl(sockFd, F_SETFL, fcntl(sockFd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+        close(sockFd);
+        throw std::runtime_error("Failed to make the EMG UDP socket non-blocking: " + std::string(strerror(errno)));
+    }
+    return sockFd;
 }
 
 void EMGUDPSimulink::stop()
 {
 	threadEnd_ = false; // Signal the communication thread to stop
+	socketWaiter_.requestStop(); // Wake it up if it is waiting for data
+	shmTransport_.wake();
 
     // Ensure the thread exists and is joinable before trying to join it
     if (feederThread && feederThread->joinable()) {
         feederThread->join(); // Wait for the thread to complete its execution
+        if (clockSync_.isEnabled()) {
+            const EMGClockSync::Estimate clock = clockSync_.getEstimate();
+            std::cout << "EMG_UDP_Simulink: Sender clock offset " << clock.offset << " s, drift " << clock.drift * 1.0e6
+                      << " ppm, last delay " << clock.delay * 1.0e6 << " us, " << clock.resets << " restarts" << std::endl;
+        }
+    }
+
+    if (metricsThread_ && metricsThread_->joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(metricsMutex_);
+            metricsEnd_ = true;
+        }
+        metricsCondition_.notify_all();
+        metricsThread_->join();
+        metricsThread_.reset();
     }
 
     // --- NEW: Save final maxAmp_ values to XML and print to console ---
-    // This is done automatically as the plugin continuously updates maxAmp_.
-    if (_executionEmgXml) {
+    // This is done automatically as the plugin continuously updates maxAmp_, except in frozen mode
+    // and after a replay, whose maxAmp_ must not replace the calibration of the subject.
+    if (_executionEmgXml && config_.calibrationMode != EMGUDPConfig::CALIBRATION_FROZEN &&
+        config_.source != EMGUDPConfig::SOURCE_REPLAY) {
         try {
             // This calls ExecutionEmgXml::setMaxEmg() which is assumed to exist (as per PluginEMGROS.cpp)
             _executionEmgXml->setMaxEmg(maxAmp_); 
@@ -221,8 +478,28 @@ void EMGUDPSimulink::stop()
 		delete _logger;
 		_logger = nullptr; // Set to nullptr to avoid dangling pointer
 	}
+	if (recorder_)
+	{
+		recorder_->stop();
+		std::cout << "EMG_UDP_Simulink: " << recorder_->getWritten() << " samples recorded, "
+			<< recorder_->getDropped() << " dropped by the recorder" << std::endl;
+		recorder_.reset();
+	}
+	if (telemetry_.isEnabled())
+	{
+		telemetry_.stop();
+		const EMGTelemetry::Counters counters = telemetry_.getCounters();
+		std::cout << "EMG_UDP_Simulink: Telemetry " << counters.sent << " samples sent, " << counters.overwritten
+			<< " overwritten before being sent, " << counters.errors << " send errors" << std::endl;
+	}
     
     // Close the socket file descriptor if it's open
+    shmTransport_.close();
+    socketWaiter_.close();
+    for (int endpointFd : endpointFds_) {
+        close(endpointFd);
+    }
+    endpointFds_.clear();
     if (emgSockFd != -1) {
         close(emgSockFd); // Unix-specific socket close
         emgSockFd = -1; // Invalidate the file descriptor
@@ -233,39 +510,85 @@ void EMGUDPSimulink::EMGFeed()
 {
 	struct sockaddr_in clientAddr; // Struct to store the sender's address
 	socklen_t clientAddrSize = sizeof(clientAddr); // Size of the sender's address struct
-	char emgUDPBuffer[1024]; // Buffer for received UDP data
+	char* emgUDPBuffer = datagramBuffer_.data(); // Buffer for received UDP data, <maxDatagram> bytes
+	const size_t bufferSize = datagramBuffer_.size() - 1; // -1 for the null terminator
 	int bytesRead;	
-	const int NBOFCHANNEL = nameVect_.size(); // Number of EMG channels expected
 	double timeInitCpy; // Local variable for timestamp
 
-    // Set a receive timeout for the socket to prevent indefinite blocking
-    // This allows the thread to check `threadEnd_` regularly and exit cleanly.
-    struct timeval tv;
-    tv.tv_sec = 0;           // 0 seconds
-    tv.tv_usec = 100000;     // 100 milliseconds
-    if (setsockopt(emgSockFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
-        std::cerr << "Warning: setsockopt(SO_RCVTIMEO) failed for EMG socket: " << strerror(errno) << std::endl;
-    }
+    configureThread();
 
-    int receiveCnt = 0; // Counter for received packets DEBUG
+    receiveCnt_ = 0; // Counter for received packets DEBUG
 
 	while (threadEnd_) { // Loop as long as the `threadEnd_` flag is true
-		std::vector<double> tempEMGdata;
-		tempEMGdata.resize(NBOFCHANNEL); // Resize vector to hold expected number of channels
+		// Sleep until data, stop() or the end of the wait for a missing sample or fragment,
+		// in spin mode the non-blocking reads below return EAGAIN until data arrives
+		if (!config_.spin)
+		{
+			int timeoutMs = -1;
+			double deadline = config_.reorderWindow > 0 ? reorder_.nextDeadline() : -1.0;
+			const double fragmentDeadline = frameAssembler_.nextDeadline();
+			if (fragmentDeadline >= 0.0 && (deadline < 0.0 || fragmentDeadline < deadline))
+				deadline = fragmentDeadline;
+			if (deadline >= 0.0)
+				timeoutMs = std::max(0, static_cast<int>(std::ceil((deadline - rtb::getTime()) * 1.0e3)));
+			EMGSocketWaiter::Event event = socketWaiter_.wait(timeoutMs);
+			if (event == EMGSocketWaiter::STOP)
+				break;
+			if (event == EMGSocketWaiter::ERROR)
+			{
+				std::cerr << "EMG Receive Failed: epoll_wait: " << strerror(errno) << std::endl;
+				break;
+			}
+		}
+		if (config_.reorderWindow > 0)
+		{
+			// Missing samples given up on while no packet arrived
+			const double now = rtb::getTime();
+			reorder_.expire(now);
+			processReordered(now);
+		}
+		frameAssembler_.expire(rtb::getTime());
 
-		// Get current time (thread-safe access)
-		timeInitMutex_.lock();
-		timenow_ = rtb::getTime();
-		timeInitCpy = timenow_;
-		timeInitMutex_.unlock();
+		if (config_.receiveMode == EMGUDPConfig::BATCH)
+		{
+			// Drain every queued datagram, each one stamped with its kernel receive time
+			int nbReceived = receiver_->receive(emgSockFd);
+			if (nbReceived < 0) {
+				if (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR) {
+					continue; // No data, just continue to next loop iteration
+				}
+				if (!threadEnd_) {
+					break;
+				}
+				std::cerr << "EMG Receive Failed: " << strerror(errno) << std::endl;
+				break; // Fatal error, break the loop
+			}
+			for (int i = 0; i < nbReceived; ++i)
+			{
+				const EMGUDPReceiver::Datagram& datagram = (*receiver_)[i];
+				if (datagram.size == 0)
+					continue;
+				if (datagram.truncated)
+				{
+					datagramTruncated(datagram.size, datagram.time);
+					continue;
+				}
+				processDatagram(datagram.data, datagram.size, datagram.time, datagram.time);
+			}
+			continue;
+		}
+
+		// Receive time, the sample time unless the sender time is mapped to the host clock
+		timeInitCpy = rtb::getTime();
 
 		// Receive data from the UDP socket
         // -1 from buffer size for null terminator
-		bytesRead = recvfrom(emgSockFd, emgUDPBuffer, sizeof(emgUDPBuffer) - 1, 0, (struct sockaddr*)&clientAddr, &clientAddrSize);
+		// MSG_TRUNC: the size on the wire is returned even if the datagram did not fit
+		bytesRead = recvfrom(emgSockFd, emgUDPBuffer, bufferSize, MSG_TRUNC, (struct sockaddr*)&clientAddr, &clientAddrSize);
 
 		if (bytesRead < 0) {
-            // Check if error is due to timeout (no data received within time)
-            if (errno == EWOULDBLOCK || errno == EAGAIN) {
+            // Nothing queued on the non-blocking socket (spurious wakeup or spin mode)
+            if (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR) {
                 continue; // No data, just continue to next loop iteration
             }
             // If the thread is signaling to stop, and it's not a timeout error, break loop
@@ -280,133 +603,545 @@ void EMGUDPSimulink::EMGFeed()
         if (bytesRead == 0) { // Should not happen for UDP usually, but defensive check
             continue;
         }
+        if (static_cast<size_t>(bytesRead) > bufferSize) {
+            datagramTruncated(bytesRead, rtb::getTime());
+            continue;
+        }
 
 		emgUDPBuffer[bytesRead] = '\0'; // Null-terminate the received string for C string functions
-		
-        
-        receiveCnt++;
-        if (receiveCnt>=1000) {
-            std::cout << "EMG_UDP_Simulink: Received " << bytesRead << " bytes. Content: '" << emgUDPBuffer << "'" << std::endl; // MODIFIED THIS LINE     
-            receiveCnt=0;
-        }
+		processDatagram(emgUDPBuffer, bytesRead, timeInitCpy, rtb::getTime());
+	}
+	if (config_.reorderWindow > 0)
+	{
+		const EMGReorderBuffer::Counters& counters = reorder_.getCounters();
+		std::cout << "EMG_UDP_Simulink: Reorder " << counters.received << " samples, " << counters.reordered << " reordered, "
+			<< counters.lost << " lost (" << counters.filled << " filled), " << counters.late << " late, "
+			<< counters.duplicates << " duplicates, " << counters.restarts << " sender restarts" << std::endl;
+	}
+	const EMGFrameAssembler::Counters& fragments = frameAssembler_.getCounters();
+	if (fragments.fragments > 0)
+		std::cout << "EMG_UDP_Simulink: Fragments " << fragments.fragments << " received, " << fragments.frames << " frames, "
+			<< fragments.incomplete << " incomplete frames dropped, " << fragments.late << " late or duplicate, "
+			<< fragments.invalid << " invalid, " << fragments.restarts << " sender restarts" << std::endl;
+    std::cout << "EMG_UDP_Simulink: UDP Communication thread stopped." << std::endl;
+}
 
+void EMGUDPSimulink::fanInFeed()
+{
+	char* emgUDPBuffer = datagramBuffer_.data();
+	const size_t bufferSize = datagramBuffer_.size() - 1;
+	double frameTime;
+	uint64_t frameSequence;
 
-        // --- NEW: Robust Parsing (replacing strtok) ---
-        std::string received_str(emgUDPBuffer);
-        
-        // Find and remove leading '[' and trailing ']'
-        size_t first_bracket = received_str.find('[');
-        size_t last_bracket = received_str.rfind(']');
-        if (first_bracket == std::string::npos || last_bracket == std::string::npos || last_bracket <= first_bracket) {
-            std::cerr << "ERROR: Received string missing brackets or malformed: " << received_str << std::endl;
-            std::fill(tempEMGdata.begin(), tempEMGdata.end(), 0.0); // Fill with zeros on error
-            continue; // Skip processing this bad packet
-        }
-        std::string inner_content = received_str.substr(first_bracket + 1, last_bracket - first_bracket - 1);
-
-        // Replace all " and , with spaces to simplify tokenization by stringstream
-        std::replace(inner_content.begin(), inner_content.end(), '"', ' ');
-        std::replace(inner_content.begin(), inner_content.end(), ',', ' ');
-        
-        std::istringstream iss(inner_content);
-        double value;
-        int iLoc = 0;
-        while (iss >> value && iLoc < NBOFCHANNEL) { // Extract doubles until end of stream or all channels filled
-            tempEMGdata[iLoc] = value;
-            iLoc++;
-        }
-        // Fill any remaining channels with 0.0 if not enough values were parsed
-        while (iLoc < NBOFCHANNEL) {
-            tempEMGdata[iLoc] = 0.0;
-            iLoc++;
-        }
+	configureThread();
 
-        // --- NEW: Continuous maxAmp Accumulation ---
-        // Max values are always tracked, regardless of calibration "mode".
-        // This is the core of the running maximum.
-        for (size_t i = 0; i < NBOFCHANNEL; ++i) {
-            // Ensure tempEMGdata[i] is non-negative before comparison if EMG is usually positive.
-            // If raw EMG can be negative (e.g., from AC-coupling/filtering), consider abs(tempEMGdata[i]).
-            // Assuming EMG values should be positive after rectification/processing for maxAmp.
-            if (tempEMGdata[i] > maxAmp_[i]) {
-                maxAmp_[i] = tempEMGdata[i];
-            }
-        }
+	receiveCnt_ = 0;
+	while (threadEnd_)
+	{
+		// Sleep until data, stop() or the stall timeout of the oldest frame being assembled
+		if (!config_.spin)
+		{
+			int timeoutMs = -1;
+			const double deadline = fanIn_.nextDeadline();
+			if (deadline >= 0.0)
+				timeoutMs = std::max(0, static_cast<int>(std::ceil((deadline - rtb::getTime()) * 1.0e3)));
+			EMGSocketWaiter::Event event = socketWaiter_.wait(timeoutMs);
+			if (event == EMGSocketWaiter::STOP)
+				break;
+			if (event == EMGSocketWaiter::ERROR)
+			{
+				std::cerr << "EMG Receive Failed: epoll_wait: " << strerror(errno) << std::endl;
+				break;
+			}
+		}
 
-        // --- NEW: Normalization Logic (Always apply if maxAmp_ is valid) ---
-        // Normalization is always applied using the current maxAmp_.
-        // If maxAmp_ for a channel is still 1.0 (from default init), normalization has no effect.
-        for (int iLoc = 0; iLoc < NBOFCHANNEL; ++iLoc) {
-            // Apply normalization using the *currently tracked* maxAmp_
-            if (maxAmp_[iLoc] > 1.0e-6) { // Avoid division by very small numbers or zero
-                tempEMGdata[iLoc] = tempEMGdata[iLoc] / maxAmp_[iLoc];
-                // Cap the normalized value at 1.0, similar to "NoMax" variant logic
-                if (tempEMGdata[iLoc] > 1.0) {
-                    tempEMGdata[iLoc] = 1.0;
-                }
-            } else {
-                // If maxAmp_ is problematic (0 or very small), treat normalized EMG as 0
-                // This means data won't be normalized (or will be 0) until maxAmp_ for that channel becomes > 0
-                tempEMGdata[iLoc] = 0.0;
-            }
+		// Drain every socket, the frames completed on the way are processed in order
+		for (size_t source = 0; source < endpointFds_.size(); ++source)
+		{
+			int bytesRead;
+			while ((bytesRead = recvfrom(endpointFds_[source], emgUDPBuffer, bufferSize, MSG_TRUNC, nullptr, nullptr)) > 0)
+			{
+				const double arrivalTime = rtb::getTime();
+				if (static_cast<size_t>(bytesRead) > bufferSize)
+				{
+					datagramTruncated(bytesRead, arrivalTime);
+					continue;
+				}
+				emgUDPBuffer[bytesRead] = '\0';
+				std::vector<double>& data = endpointData_[source];
+				bool binaryPacket;
+				if (!decodeDatagram(emgUDPBuffer, bytesRead, arrivalTime, data.data(), data.size(), binaryPacket))
+					continue;
+				// Text packets have neither sequence nor sender time: packet count and receive time
+				const uint64_t sequence = binaryPacket ? lastHeader_.sequence : endpointPackets_[source];
+				endpointPackets_[source]++;
+				fanIn_.add(source, data.data(), sequence, binaryPacket ? lastHeader_.senderTime : arrivalTime, arrivalTime);
+				while (fanIn_.pop(fanInFrame_.data(), frameTime, frameSequence))
+				{
+					metrics_.sequence(static_cast<uint32_t>(frameSequence));
+					processSample(fanInFrame_, frameTime, frameSequence, frameTime);
+				}
+			}
+			if (bytesRead < 0 && errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR && threadEnd_)
+				std::cerr << "EMG Receive Failed: " << strerror(errno) << std::endl;
+		}
+
+		// Frames a stalled source never completed
+		fanIn_.expire(rtb::getTime());
+		while (fanIn_.pop(fanInFrame_.data(), frameTime, frameSequence))
+		{
+			metrics_.sequence(static_cast<uint32_t>(frameSequence));
+			processSample(fanInFrame_, frameTime, frameSequence, frameTime);
+		}
+	}
+	const EMGFanIn::Counters& counters = fanIn_.getCounters();
+	std::cout << "EMG_UDP_Simulink: Fan-in " << counters.frames << " frames, " << counters.incomplete << " incomplete, "
+		<< counters.dropped << " dropped, " << counters.late << " late samples, " << counters.restarts << " sender restarts" << std::endl;
+	std::cout << "EMG_UDP_Simulink: UDP Communication thread stopped." << std::endl;
+}
+
+void EMGUDPSimulink::replayFeed()
+{
+	const size_t nbChannel = nameVect_.size();
+	std::vector<double> sample(nbChannel);
+	// Large enough for the text format of any channel count
+	std::vector<char> packet(EMGBinaryPacket::HEADER_SIZE + nbChannel * 32 + 16);
+	uint32_t sequence = 0;
+	double replayTime;
+
+	configureThread();
+
+	receiveCnt_ = 0;
+	while (threadEnd_ && replaySource_.next(sample.data(), replayTime))
+	{
+		if (replaySource_.isNormalized())
+		{
+			// A .sto of the plugin holds the published values: not conditioned nor normalized twice
+			const double arrivalTime = rtb::getTime();
+			metrics_.packetDecoded(true, 0);
+			metrics_.packetReceived(arrivalTime, -1.0);
+			metrics_.sequence(sequence);
+			if (recorder_)
+				std::copy(sample.begin(), sample.end(), recordSample_.begin());
+			publishSample(sample, replayTime, sequence, arrivalTime);
+			sequence++;
+			continue;
+		}
+
+		// Same path as a received datagram, time stamped with the recorded time for reproducible runs
+		size_t size;
+		if (config_.packetFormat == EMGUDPConfig::TEXT)
+			size = EMGTextParser::format(packet.data(), packet.size() - 1, sample.data(), nbChannel);
+		else
+			size = EMGBinaryPacket::encode(packet.data(), packet.size() - 1, sample.data(), nbChannel, sequence, replayTime);
+		sequence++;
+		if (size == 0)
+			continue;
+		packet[size] = '\0';
+
+		processDatagram(packet.data(), static_cast<int>(size), replayTime, rtb::getTime());
+	}
+	std::cout << "EMG_UDP_Simulink: Replay of " << config_.replayFile << " " << (threadEnd_ ? "finished." : "stopped.") << std::endl;
+}
+
+void EMGUDPSimulink::shmFeed()
+{
+	const uint64_t spinNs = static_cast<uint64_t>(config_.shmSpin) * 1000;
+	uint32_t sequence;
+	double senderTime;
+	uint64_t writeNs;
+
+	configureThread();
+
+	receiveCnt_ = 0;
+	while (threadEnd_)
+	{
+		if (!shmTransport_.read(mixer_.isEnabled() ? mixerInput_.data() : receiveSample_.data(), sequence, senderTime, writeNs))
+		{
+			// With <realtime><spin>, poll without ever sleeping: no system call at all
+			if (!config_.spin)
+				shmTransport_.wait(spinNs, 100);
+			continue;
+		}
+		if (mixer_.isEnabled())
+			mixer_.process(mixerInput_.data(), receiveSample_.data());
+
+		// Receive time back-dated to the write, so the latency metrics include the transport
+		const double readTime = rtb::getTime();
+		const uint64_t nowNs = EMGShmTransport::nowNs();
+		const double arrivalTime = readTime - (nowNs > writeNs ? (nowNs - writeNs) * 1.0e-9 : 0.0);
+		const double timeInitCpy = clockSync_.isEnabled() ? clockSync_.map(senderTime, arrivalTime) : arrivalTime;
+		metrics_.packetDecoded(true, 0);
+		metrics_.packetReceived(arrivalTime, senderTime);
+		metrics_.sequence(sequence);
+
+		receiveCnt_++;
+		if (receiveCnt_ >= 1000)
+		{
+			std::cout << "EMG_UDP_Simulink: Shared memory sample sequence: " << sequence << std::endl;
+			receiveCnt_ = 0;
+		}
+
+		processSample(receiveSample_, timeInitCpy, sequence, arrivalTime);
+	}
+	const EMGShmTransport::Counters& counters = shmTransport_.getCounters();
+	std::cout << "EMG_UDP_Simulink: Shared memory " << counters.samples << " samples, " << counters.overruns
+		<< " overwritten before being read, " << counters.sleeps << " futex waits" << std::endl;
+}
+
+void EMGUDPSimulink::configureThread()
+{
+	if (config_.realtimeLockMemory)
+		EMGRealtime::lockMemory(256 * 1024);
+	if (!config_.realtimeCpus.empty())
+		EMGRealtime::setAffinity(config_.realtimeCpus);
+	if (config_.realtimePriority > 0)
+		EMGRealtime::setFifoPriority(config_.realtimePriority);
+}
+
+void EMGUDPSimulink::publishTelemetry(const double* data, double time, uint64_t sequence)
+{
+	if (!telemetry_.isEnabled() || !telemetry_.tick())
+		return;
+	// Counters only, the histogram summaries are too long for the receive thread
+	EMGMetrics::Snapshot counters;
+	metrics_.readCounters(counters, sampleRing_->getCounters());
+	const EMGTelemetry::Health health = { counters.received, counters.malformed, counters.sequenceGaps, counters.lost,
+		counters.overruns, counters.dropped, counters.deadlineMisses, 0 };
+	telemetry_.push(data, maxAmp_.data(), time, sequence, health);
+}
+
+void EMGUDPSimulink::metricsReport()
+{
+	std::ofstream file(config_.metricsFile.c_str());
+	if (!file)
+	{
+		std::cerr << "Warning: Cannot create the EMG metrics file " << config_.metricsFile << std::endl;
+		return;
+	}
+	EMGMetrics::writeHeader(file);
+
+	const std::chrono::duration<double> period(config_.metricsPeriod);
+	std::unique_lock<std::mutex> lock(metricsMutex_);
+	bool end = false;
+	while (!end)
+	{
+		end = metricsCondition_.wait_for(lock, period, [this] { return metricsEnd_; });
+		// Last row on stop with the final counters
+		EMGMetrics::writeRow(file, rtb::getTime(), getMetrics());
+	}
+}
+
+bool EMGUDPSimulink::decodeDatagram(const char* emgUDPBuffer, int bytesRead, double arrivalTime, double* data, size_t nbChannel, bool& binaryPacket)
+{
+	binaryPacket = config_.packetFormat == EMGUDPConfig::BINARY ||
+		(config_.packetFormat == EMGUDPConfig::AUTO && EMGBinaryPacket::isBinary(emgUDPBuffer, bytesRead));
+
+	bool decoded = true;
+	const uint64_t parseStart = EMGMetrics::now();
+	if (binaryPacket)
+	{
+		// Decoded straight from the receive buffer
+		EMGBinaryPacket::Status status = EMGBinaryPacket::decode(emgUDPBuffer, bytesRead, data, nbChannel, lastHeader_);
+		if (status == EMGBinaryPacket::FRAGMENT && nbChannel == frameAssembler_.getNbChannel())
+		{
+			// Decoded into the frame being reassembled, processed once its last fragment arrived
+			decoded = frameAssembler_.add(lastHeader_, emgUDPBuffer, bytesRead, arrivalTime, data);
+			if (decoded)
+			{
+				metrics_.packetDecoded(true, EMGMetrics::now() - parseStart);
+				metrics_.packetReceived(arrivalTime, lastHeader_.senderTime);
+			}
+		}
+		else
+		{
+			decoded = status == EMGBinaryPacket::OK;
+			metrics_.packetDecoded(decoded, EMGMetrics::now() - parseStart);
+			metrics_.packetReceived(arrivalTime, decoded ? lastHeader_.senderTime : -1.0);
+			if (!decoded)
+				binaryErrors_[status]++; // Skip processing this bad packet, reported by the periodic print
+		}
+	}
+	else
+	{
+		decoded = textParser_.parse(emgUDPBuffer, bytesRead, data, nbChannel);
+		metrics_.packetDecoded(decoded, EMGMetrics::now() - parseStart);
+		metrics_.packetReceived(arrivalTime, -1.0);
+		// A bad packet is skipped, counted in textParser_
+	}
+
+	// After the decoding, so that the binary header printed is the one of this packet
+    receiveCnt_++;
+    if (receiveCnt_>=1000) {
+        if (binaryPacket)
+            std::cout << "EMG_UDP_Simulink: Received " << bytesRead << " bytes. Binary packet sequence: " << lastHeader_.sequence << std::endl;
+        else
+        {
+            // Beginning of the content only, high-density frames are several kB long
+            std::cout << "EMG_UDP_Simulink: Received " << bytesRead << " bytes. Content: '";
+            std::cout.write(emgUDPBuffer, std::min(bytesRead, 120));
+            std::cout << (bytesRead > 120 ? "...'" : "'") << std::endl;
         }
+        const EMGTextParser::Counters& parseCounters = textParser_.getCounters();
+        if (parseCounters.malformed + parseCounters.incomplete + parseCounters.invalidValues > 0)
+            std::cerr << "EMG_UDP_Simulink: Text parse errors: " << parseCounters.malformed << " malformed, "
+                      << parseCounters.incomplete << " incomplete, " << parseCounters.invalidValues << " invalid values" << std::endl;
+        for (int status = EMGBinaryPacket::TOO_SHORT; status <= EMGBinaryPacket::BAD_FRAGMENT; ++status)
+            if (binaryErrors_[status] > 0)
+                std::cerr << "EMG_UDP_Simulink: Binary packets skipped: " << binaryErrors_[status] << " "
+                          << EMGBinaryPacket::statusString(static_cast<EMGBinaryPacket::Status>(status)) << std::endl;
+        const EMGSampleRing::Counters ringCounters = sampleRing_->getCounters();
+        if (ringCounters.overruns + ringCounters.dropped > 0)
+            std::cerr << "EMG_UDP_Simulink: Samples " << ringCounters.overruns << " overrun, " << ringCounters.dropped << " dropped by GetDataMap()" << std::endl;
+        receiveCnt_=0;
+    }
+	return decoded;
+}
+
+void EMGUDPSimulink::processDatagram(const char* emgUDPBuffer, int bytesRead, double timeInitCpy, double arrivalTime)
+{
+	const int NBOFCHANNEL = nameVect_.size(); // Number of EMG channels expected
+	// Preallocated in init(), no allocation per datagram
+	std::vector<double>& tempEMGdata = receiveSample_;
 
+	bool binaryPacket;
+	if (mixer_.isEnabled())
+	{
+		// Received channels first, then mixed into the channels of the subject XML
+		if (!decodeDatagram(emgUDPBuffer, bytesRead, arrivalTime, mixerInput_.data(), mixerInput_.size(), binaryPacket))
+			return;
+		mixer_.process(mixerInput_.data(), tempEMGdata.data());
+	}
+	else if (!decodeDatagram(emgUDPBuffer, bytesRead, arrivalTime, tempEMGdata.data(), NBOFCHANNEL, binaryPacket))
+		return;
+
+	// Binary packets always carry a sequence number, text packets when it prefixes the values
+	uint32_t wireSequence = 0;
+	bool hasSequence = binaryPacket;
+	if (binaryPacket)
+		wireSequence = lastHeader_.sequence;
+	else
+		hasSequence = EMGTextParser::parseSequence(emgUDPBuffer, bytesRead, wireSequence);
+	if (hasSequence)
+		metrics_.sequence(wireSequence);
 
-		EMGMutex_.lock();
-		dataEMG_ = tempEMGdata; // Copy processed (accumulated max / normalized) data to shared member
-		newData_ = true;        // Signal that new data is available
-		EMGMutex_.unlock();
+	// Acquisition time on the host clock instead of the receive time
+	if (binaryPacket && clockSync_.isEnabled())
+		timeInitCpy = clockSync_.map(lastHeader_.senderTime, arrivalTime);
 
-		// Log data if recording is enabled
-		if (_record)
+	if (hasSequence && config_.reorderWindow > 0)
+	{
+		// Released in sequence order, possibly with filled gaps, a late packet is discarded
+		reorder_.push(wireSequence, tempEMGdata.data(), timeInitCpy, arrivalTime);
+		processReordered(arrivalTime);
+		return;
+	}
+	const uint64_t sequence = hasSequence ? wireSequence : sampleSequence_;
+	sampleSequence_++;
+	processSample(tempEMGdata, timeInitCpy, sequence, arrivalTime);
+}
+
+void EMGUDPSimulink::processReordered(double arrivalTime)
+{
+	double sampleTime;
+	uint64_t sequence;
+	bool filled;
+	while (reorder_.pop(reorderSample_.data(), sampleTime, sequence, filled))
+	{
+		if (!filled || reorder_.getGapFill() != EMGReorderBuffer::NAN_MARK)
+		{
+			processSample(reorderSample_, sampleTime, sequence, arrivalTime);
+			continue;
+		}
+		// The gap is visible to the model as NaN; the decimated output skips it
+		if (config_.resampling != EMGUDPConfig::RESAMPLE_DECIMATE)
+		{
+			const double publishTime = rtb::getTime();
+			sampleRing_->push(reorderSample_.data(), sampleTime, sequence, publishTime);
+			metrics_.published(publishTime - arrivalTime);
+		}
+		timenow_.store(sampleTime, std::memory_order_release);
+		if (recorder_)
+		{
+			std::copy(reorderSample_.begin(), reorderSample_.end(), recordSample_.begin());
+			std::copy(reorderSample_.begin(), reorderSample_.end(), recordSample_.begin() + reorderSample_.size());
+			recorder_->push(recordSample_.data(), sampleTime, sequence);
+		}
+		else if (_record)
 		{
 			loggerMutex_.lock();
-			_logger->log(Logger::EmgsFilter, timeInitCpy, tempEMGdata);
+			_logger->log(Logger::EmgsFilter, sampleTime, reorderSample_);
 			loggerMutex_.unlock();
 		}
 	}
-    std::cout << "EMG_UDP_Simulink: UDP Communication thread stopped." << std::endl;
+	const EMGReorderBuffer::Counters& counters = reorder_.getCounters();
+	metrics_.reorderCounters(counters.lost, counters.filled, counters.late + counters.duplicates);
 }
 
-const std::map<std::string, double>& EMGUDPSimulink::GetDataMap()
+void EMGUDPSimulink::datagramTruncated(size_t size, double arrivalTime)
 {
-	// Local vector to safely copy data
-	std::vector<double> dataEMGSafe;
-	DataMutex_.lock(); // Lock mutex before accessing shared data
+	metrics_.packetDecoded(false, 0);
+	metrics_.packetReceived(arrivalTime, -1.0);
+	std::cerr << "ERROR: Received EMG datagram of " << size << " bytes, larger than <maxDatagram> " << config_.maxDatagram
+		<< ": skipped." << std::endl;
+}
 
-	if (newData_) // Check if there's new data available
+void EMGUDPSimulink::processSample(std::vector<double>& tempEMGdata, double timeInitCpy, uint64_t sequence, double arrivalTime)
+{
+	const int NBOFCHANNEL = nameVect_.size(); // Number of EMG channels expected
+
+	// Keep the decoded values for the binary recording
+	if (recorder_)
+		std::copy(tempEMGdata.begin(), tempEMGdata.end(), recordSample_.begin());
+
+	// Raw EMG to envelope: DC removal, high-pass, rectification, low-pass
+	if (config_.conditioning)
 	{
-		dataEMGSafe = dataEMG_; // Copy data
-		newData_ = false;       // Reset flag, data has been consumed
+		conditioner_.process(tempEMGdata.data());
 	}
-	else
+
+	if (config_.calibrationMode == EMGUDPConfig::CALIBRATION_RUNNING)
+	{
+		// Running maximum, <calibration><mode>running</mode> (default).
+		kernels_.updateMax(tempEMGdata.data(), maxAmp_.data(), NBOFCHANNEL);
+	}
+	else if (calibrating_)
+	{
+		// Windowed RMS / percentile estimate with outlier clipping, maxAmp_ is frozen otherwise
+		if (calibrationReset_.exchange(false))
+		{
+			calibrator_.reset();
+			calibrationStart_ = std::numeric_limits<double>::quiet_NaN();
+		}
+		calibrator_.update(tempEMGdata.data(), maxAmp_.data());
+
+		// <calibration><duration>: frozen once that many seconds of samples were seen
+		if (std::isnan(calibrationStart_))
+			calibrationStart_ = timeInitCpy;
+		else if (config_.calibrationDuration > 0.0 && timeInitCpy - calibrationStart_ >= config_.calibrationDuration)
+		{
+			calibrating_ = false;
+			std::cout << "EMG_UDP_Simulink: Calibration frozen after " << config_.calibrationDuration << " s." << std::endl;
+		}
+	}
+
+    // Normalization with the current maxAmp_, capped at 1.0; channels whose maxAmp_ is 0 or
+    // very small give 0 until it grows. Branch-free, specialized on the channel count.
+    kernels_.normalize(tempEMGdata.data(), maxAmp_.data(), NBOFCHANNEL);
+
+	publishSample(tempEMGdata, timeInitCpy, sequence, arrivalTime);
+}
+
+void EMGUDPSimulink::publishSample(const std::vector<double>& tempEMGdata, double timeInitCpy, uint64_t sequence, double arrivalTime)
+{
+	const int NBOFCHANNEL = nameVect_.size(); // Number of EMG channels expected
+
+	// Publish the processed (accumulated max / normalized) data, a full ring is counted as overrun
+	if (config_.resampling == EMGUDPConfig::RESAMPLE_DECIMATE)
 	{
-		DataMutex_.unlock(); // Unlock before returning if no new data
-		// If no new data, fill map with zeros
-		for (const auto& name : nameVect_) // C++11 range-based for loop
+		// Only one sample every <decimation> packets reaches GetDataMap()
+		double decimatedTime;
+		if (decimator_.process(tempEMGdata.data(), timeInitCpy, decimatedEMGdata_.data(), decimatedTime))
 		{
-			mapData_[name] = 0.0;
+			const double publishTime = rtb::getTime();
+			sampleRing_->push(decimatedEMGdata_.data(), decimatedTime, sequence, publishTime);
+			metrics_.published(publishTime - arrivalTime);
+			publishTelemetry(decimatedEMGdata_.data(), decimatedTime, sequence);
 		}
-		return mapData_;
 	}
-	DataMutex_.unlock(); // Unlock mutex after accessing shared data
+	else
+	{
+		const double publishTime = rtb::getTime();
+		sampleRing_->push(tempEMGdata.data(), timeInitCpy, sequence, publishTime);
+		metrics_.published(publishTime - arrivalTime);
+		publishTelemetry(tempEMGdata.data(), timeInitCpy, sequence);
+	}
+	timenow_.store(timeInitCpy, std::memory_order_release);
+
+	// Log data if recording is enabled
+	if (recorder_)
+	{
+		// Non-blocking, written to disk by the recorder thread
+		std::copy(tempEMGdata.begin(), tempEMGdata.end(), recordSample_.begin() + NBOFCHANNEL);
+		recorder_->push(recordSample_.data(), timeInitCpy, sequence);
+	}
+	else if (_record)
+	{
+		loggerMutex_.lock();
+		_logger->log(Logger::EmgsFilter, timeInitCpy, tempEMGdata);
+		loggerMutex_.unlock();
+	}
+}
+
+void EMGUDPSimulink::startCalibration()
+{
+	if (config_.calibrationMode == EMGUDPConfig::CALIBRATION_RUNNING)
+	{
+		std::cerr << "Warning: EMG_UDP_Simulink calibration needs <calibration><mode> calibrate or frozen." << std::endl;
+		return;
+	}
+	calibrationReset_ = true;
+	calibrating_ = true;
+}
+
+void EMGUDPSimulink::stopCalibration()
+{
+	calibrating_ = false;
+}
+
+const EMGSampleView& EMGUDPSimulink::GetDataVector()
+{
+	if (!sampleRing_)
+		return sampleView_;
 
-    // Check for data size consistency after copying
-	if (dataEMGSafe.empty() || dataEMGSafe.size() < nameVect_.size())
+	// Pull mode: wait for a sample newer than the last one read, at most <pull><deadline> after the call
+	if (config_.pullDeadline > 0.0)
 	{
-        std::cerr << "Warning: EMG data size mismatch or empty after copy. Received: " << dataEMGSafe.size()
-                  << ", Expected: " << nameVect_.size() << ". Filling with zeros." << std::endl;
-		for (const auto& name : nameVect_)
+		const uint64_t waitStart = EMGMetrics::now();
+		const EMGSampleRing::WaitResult result = sampleRing_->waitForData(static_cast<uint64_t>(config_.pullSpin) * 1000,
+			static_cast<uint64_t>(config_.pullDeadline * 1.0e9));
+		metrics_.pulled(result, EMGMetrics::now() - waitStart);
+	}
+
+	if (config_.resampling == EMGUDPConfig::RESAMPLE_MEAN || config_.resampling == EMGUDPConfig::RESAMPLE_MAX)
+	{
+		// Reduce everything received since the last read, the ring has to hold one control period
+		double sampleTime;
+		uint64_t sequence;
+		double readTime = 0.0;
+		windowReducer_.begin();
+		while (sampleRing_->readOldest(windowSample_.data(), sampleTime, sequence))
 		{
-			mapData_[name] = 0.0;
+			if (readTime == 0.0)
+				readTime = rtb::getTime();
+			metrics_.consumed(readTime - sampleRing_->getLastPublished());
+			windowReducer_.add(windowSample_.data(), sampleTime);
+			sampleView_.sequence = sequence;
 		}
-		return mapData_;
+		sampleView_.fresh = windowReducer_.finish(dataEMGSafe_.data(), sampleView_.time);
 	}
+	else
+	{
+		// Wait-free read of the sample ring (only consumer)
+		sampleView_.fresh = sampleRing_->read(config_.readPolicy, dataEMGSafe_.data(), sampleView_.time, sampleView_.sequence);
+		if (sampleView_.fresh)
+			metrics_.consumed(rtb::getTime() - sampleRing_->getLastPublished());
+	}
+	if (!sampleView_.fresh && config_.readPolicy != EMGSampleRing::HOLD_LAST)
+	{
+		// If no new data, zeros, the time and sequence of the last sample are kept
+		std::fill(dataEMGSafe_.begin(), dataEMGSafe_.end(), 0.0);
+	}
+	return sampleView_;
+}
 
-	// Fill the map with received data
-	for (size_t idx = 0; idx < nameVect_.size(); ++idx)
+const std::map<std::string, double>& EMGUDPSimulink::GetDataMap()
+{
+	// The map is only a view built from the index-ordered sample when requested
+	const EMGSampleView& sample = GetDataVector();
+	for (size_t idx = 0; idx < mapValues_.size(); ++idx)
 	{
-		mapData_[nameVect_[idx]] = dataEMGSafe[idx];
+		*mapValues_[idx] = sample.data[idx];
 	}
 	return mapData_;
 }